@@ -0,0 +1,145 @@
+#include "counting-allocator.hpp"
+
+#include <leakyvec/leakyvec.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+// Byte sizes from 16 B to 1 GiB
+constexpr int64_t min_size = 16;
+constexpr int64_t max_size = int64_t{1} << 30;
+
+void byte_sizes(benchmark::internal::Benchmark* bench)
+{
+    bench->RangeMultiplier(16)->Range(min_size, max_size);
+}
+
+template<typename Alloc>
+std::vector<uint8_t, Alloc> make_vec(const benchmark::State& state)
+{
+    return std::vector<uint8_t, Alloc>(static_cast<size_t>(state.range(0)), 0xA5, Alloc());
+}
+
+void set_bytes_processed(benchmark::State& state)
+{
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+/// A full leak() -> from_parts() -> take() round trip that copies the allocator along the way;
+/// should be independent of the size
+template<typename Alloc>
+void BM_LeakFromPartsTake(benchmark::State& state)
+{
+    auto vec = make_vec<Alloc>(state);
+    for (auto _ : state)
+    {
+        auto leaky_vec = leaky::Vec<uint8_t, Alloc>(std::move(vec));
+        const auto parts = leaky_vec.leak();
+        benchmark::DoNotOptimize(parts);
+        vec = leaky::Vec<uint8_t, Alloc>::from_parts(parts).take();
+        benchmark::DoNotOptimize(vec.data());
+    }
+    set_bytes_processed(state);
+}
+
+/// A full leak() -> from_parts() -> take() round trip that moves the allocator along the way
+template<typename Alloc>
+void BM_LeakFromPartsTakeMove(benchmark::State& state)
+{
+    auto vec = make_vec<Alloc>(state);
+    for (auto _ : state)
+    {
+        auto parts = leaky::Vec<uint8_t, Alloc>(std::move(vec)).leak();
+        benchmark::DoNotOptimize(parts);
+        vec = leaky::Vec<uint8_t, Alloc>::from_parts(std::move(parts)).take();
+        benchmark::DoNotOptimize(vec.data());
+    }
+    set_bytes_processed(state);
+}
+
+/// Just the leak() half of the round trip, along with manually freeing the leaked memory
+///
+/// Each iteration leaks a whole batch of vectors that's built while the timer is paused, so the
+/// cost of pausing and resuming it is spread over the batch rather than paid for every vector.
+/// Compare the items per second, not the time per iteration, across sizes.
+template<typename Alloc>
+void BM_LeakAndDeallocate(benchmark::State& state)
+{
+    // Up to 1024 vectors, without allocating more than 64 MiB at once
+    constexpr int64_t max_batch = 1024;
+    constexpr int64_t max_batch_bytes = int64_t{64} << 20;
+    const auto batch_size = std::clamp<int64_t>(max_batch_bytes / state.range(0), 1, max_batch);
+
+    auto batch = std::vector<std::vector<uint8_t, Alloc>>();
+    batch.reserve(static_cast<size_t>(batch_size));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        batch.clear();
+        for (int64_t i = 0; i < batch_size; i++)
+        {
+            batch.push_back(make_vec<Alloc>(state));
+        }
+        state.ResumeTiming();
+
+        for (auto& vec : batch)
+        {
+            auto [data, size, capacity, alloc] = leaky::Vec<uint8_t, Alloc>(std::move(vec)).leak();
+            benchmark::DoNotOptimize(data);
+            benchmark::DoNotOptimize(size);
+            alloc.deallocate(data, capacity);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch_size);
+    state.SetBytesProcessed(state.iterations() * batch_size * state.range(0));
+}
+
+/// The alternative to leaking: copying the vector's contents into a new vector
+template<typename Alloc>
+void BM_Copy(benchmark::State& state)
+{
+    const auto vec = make_vec<Alloc>(state);
+    for (auto _ : state)
+    {
+        auto copy = vec;
+        benchmark::DoNotOptimize(copy.data());
+        benchmark::ClobberMemory();
+    }
+    set_bytes_processed(state);
+}
+
+/// The cheapest possible ownership transfer between two std::vectors
+template<typename Alloc>
+void BM_Swap(benchmark::State& state)
+{
+    auto vec = make_vec<Alloc>(state);
+    auto other = std::vector<uint8_t, Alloc>(vec.get_allocator());
+    for (auto _ : state)
+    {
+        vec.swap(other);
+        benchmark::DoNotOptimize(vec.data());
+        benchmark::DoNotOptimize(other.data());
+    }
+    set_bytes_processed(state);
+}
+
+using DefaultAlloc = std::allocator<uint8_t>;
+using StatefulAlloc = bench::CountingAllocator<uint8_t>;
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_LeakFromPartsTake, DefaultAlloc)->Apply(byte_sizes);
+BENCHMARK_TEMPLATE(BM_LeakFromPartsTake, StatefulAlloc)->Apply(byte_sizes);
+BENCHMARK_TEMPLATE(BM_LeakFromPartsTakeMove, DefaultAlloc)->Apply(byte_sizes);
+BENCHMARK_TEMPLATE(BM_LeakFromPartsTakeMove, StatefulAlloc)->Apply(byte_sizes);
+BENCHMARK_TEMPLATE(BM_LeakAndDeallocate, DefaultAlloc)->Apply(byte_sizes);
+BENCHMARK_TEMPLATE(BM_LeakAndDeallocate, StatefulAlloc)->Apply(byte_sizes);
+BENCHMARK_TEMPLATE(BM_Copy, DefaultAlloc)->Apply(byte_sizes);
+BENCHMARK_TEMPLATE(BM_Copy, StatefulAlloc)->Apply(byte_sizes);
+BENCHMARK_TEMPLATE(BM_Swap, DefaultAlloc)->Apply(byte_sizes);
+BENCHMARK_TEMPLATE(BM_Swap, StatefulAlloc)->Apply(byte_sizes);
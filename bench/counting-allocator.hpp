@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace bench {
+
+/// @brief Allocator call counters shared between copies of a CountingAllocator
+///
+/// The counters are sharded over cache lines, like the ledger's, so that threads allocating
+/// concurrently don't contend for them, and counting doesn't skew multithreaded benchmarks.
+struct AllocCounters
+{
+    static constexpr size_t shard_count = 16;
+
+    /// @brief Counters on their own cache line, so that threads don't contend for them
+    struct alignas(64) Shard
+    {
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> deallocations{0};
+    };
+
+    Shard shards[shard_count];
+
+    /// @brief The calling thread's shard; threads are spread over the shards round-robin
+    Shard& this_thread_shard() noexcept
+    {
+        static std::atomic<size_t> next_shard{0};
+        thread_local const size_t shard =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % shard_count;
+        return shards[shard];
+    }
+
+    [[nodiscard]] size_t allocations() const noexcept
+    {
+        size_t total = 0;
+        for (const auto& shard : shards)
+        {
+            total += shard.allocations.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    [[nodiscard]] size_t deallocations() const noexcept
+    {
+        size_t total = 0;
+        for (const auto& shard : shards)
+        {
+            total += shard.deallocations.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+};
+
+/// @brief A stateful allocator that counts its calls, and otherwise defers to std::allocator
+///
+/// Like testing::MockAllocator, its state lives behind a std::shared_ptr, so copying the allocator
+/// costs an atomic reference count increment. Unlike testing::LogAllocator, it doesn't do any I/O,
+/// so it's cheap enough to benchmark with.
+template<typename T>
+struct CountingAllocator
+{
+    using value_type = T;
+    // Move the counters along with the memory, rather than moving element by element
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    std::shared_ptr<AllocCounters> counters;
+
+    CountingAllocator() : counters(std::make_shared<AllocCounters>()) {}
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept : counters(other.counters)
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        counters->this_thread_shard().allocations.fetch_add(1, std::memory_order_relaxed);
+        return std::allocator<T>{}.allocate(n);
+    }
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        counters->this_thread_shard().deallocations.fetch_add(1, std::memory_order_relaxed);
+        std::allocator<T>{}.deallocate(p, n);
+    }
+};
+
+template<class T, class U>
+bool operator==(const CountingAllocator<T>& lhs, const CountingAllocator<U>& rhs)
+{
+    return lhs.counters == rhs.counters;
+}
+
+template<class T, class U>
+bool operator!=(const CountingAllocator<T>& lhs, const CountingAllocator<U>& rhs)
+{
+    return !(lhs == rhs);
+}
+}  // namespace bench
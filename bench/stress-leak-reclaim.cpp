@@ -0,0 +1,469 @@
+/// A multithreaded stress test and throughput benchmark for handing vectors between threads
+///
+/// N producer threads build vectors and leak them into rings, and M consumer threads reconstruct
+/// them with `from_parts()` and destroy them, with each of the allocators below. It reports the
+/// throughput, the latency percentiles of both halves, and the number of allocator calls, and
+/// checks that every vector arrives intact. It doesn't depend on Google Benchmark, so that it can
+/// be built with `-DLEAKY_USE_ASAN=ON` or `-DLEAKY_USE_TSAN=ON`.
+#include "counting-allocator.hpp"
+
+#include <leakyvec/arena-allocator.hpp>
+#include <leakyvec/buffer-pool.hpp>
+#include <leakyvec/leakyvec.hpp>
+#include <leakyvec/parts-ring.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    size_t producers = 1;
+    size_t consumers = 1;
+    /// When non-zero, run with 1, 2, 4, ... up to this many producers and as many consumers
+    size_t sweep = 0;
+    /// The total number of vectors, split between the producers
+    size_t ops = 500000;
+    size_t size = 256;
+    size_t ring = 1024;
+    std::string allocator = "all";
+};
+
+/// Latency samples in nanoseconds, recorded by a single thread
+using Samples = std::vector<uint32_t>;
+
+uint32_t elapsed_ns(Clock::time_point start)
+{
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+    return static_cast<uint32_t>(std::min<int64_t>(ns.count(), UINT32_MAX));
+}
+
+template<typename Alloc>
+using Parts = std::tuple<uint8_t*, size_t, size_t, Alloc>;
+
+template<typename Alloc>
+void destroy(Parts<Alloc>&& parts)
+{
+    static_cast<void>(leaky::Vec<uint8_t, Alloc>::from_parts(std::move(parts)).take());
+}
+
+/// std::allocator, which is stateless, so its calls aren't counted
+struct DefaultPolicy
+{
+    using Alloc = std::allocator<uint8_t>;
+    static constexpr const char* name = "default";
+
+    explicit DefaultPolicy(size_t /*producers*/) {}
+
+    std::vector<uint8_t, Alloc> make(size_t /*producer*/, size_t size)
+    {
+        return std::vector<uint8_t, Alloc>(size);
+    }
+    void reclaim(size_t /*producer*/, Parts<Alloc>&& parts) { destroy(std::move(parts)); }
+    std::shared_ptr<bench::AllocCounters> counters() const { return nullptr; }
+};
+
+/// A counting allocator shared by every thread, so every copy bumps the same reference count
+struct StatefulPolicy
+{
+    using Alloc = bench::CountingAllocator<uint8_t>;
+    static constexpr const char* name = "stateful";
+
+    Alloc m_alloc;
+
+    explicit StatefulPolicy(size_t /*producers*/) {}
+
+    std::vector<uint8_t, Alloc> make(size_t /*producer*/, size_t size)
+    {
+        return std::vector<uint8_t, Alloc>(size, m_alloc);
+    }
+    void reclaim(size_t /*producer*/, Parts<Alloc>&& parts) { destroy(std::move(parts)); }
+    std::shared_ptr<bench::AllocCounters> counters() const { return m_alloc.counters; }
+};
+
+/// A BufferPool per producer, which the consumers recycle the blocks into
+struct PoolPolicy
+{
+    using Alloc = bench::CountingAllocator<uint8_t>;
+    static constexpr const char* name = "pool";
+
+    Alloc m_alloc;
+    std::vector<std::unique_ptr<leaky::BufferPool<uint8_t, Alloc>>> m_pools;
+
+    explicit PoolPolicy(size_t producers)
+    {
+        for (size_t i = 0; i < producers; i++)
+        {
+            m_pools.push_back(std::make_unique<leaky::BufferPool<uint8_t, Alloc>>(m_alloc));
+        }
+    }
+
+    std::vector<uint8_t, Alloc> make(size_t producer, size_t size)
+    {
+        auto vec = m_pools[producer]->acquire(size);
+        vec.resize(size);
+        return vec;
+    }
+    void reclaim(size_t producer, Parts<Alloc>&& parts)
+    {
+        m_pools[producer]->recycle(std::move(parts));
+    }
+    std::shared_ptr<bench::AllocCounters> counters() const { return m_alloc.counters; }
+};
+
+/// An Arena per producer. Deallocating is a no-op, so the arenas grow by `ops * size` bytes.
+struct ArenaPolicy
+{
+    using Alloc = leaky::ArenaAllocator<uint8_t>;
+    static constexpr const char* name = "arena";
+
+    std::vector<std::unique_ptr<leaky::Arena>> m_arenas;
+
+    explicit ArenaPolicy(size_t producers)
+    {
+        for (size_t i = 0; i < producers; i++)
+        {
+            m_arenas.push_back(std::make_unique<leaky::Arena>());
+        }
+    }
+
+    std::vector<uint8_t, Alloc> make(size_t producer, size_t size)
+    {
+        return std::vector<uint8_t, Alloc>(size, Alloc(*m_arenas[producer]));
+    }
+    void reclaim(size_t /*producer*/, Parts<Alloc>&& parts) { destroy(std::move(parts)); }
+    std::shared_ptr<bench::AllocCounters> counters() const { return nullptr; }
+};
+
+struct Result
+{
+    size_t ops = 0;
+    size_t errors = 0;
+    double seconds = 0;
+    Samples leak;
+    Samples reclaim;
+    std::shared_ptr<bench::AllocCounters> counters;
+};
+
+/// @brief Hand `opts.ops` vectors from the producers to the consumers, through a ring per producer
+template<typename Policy>
+Result run(const Options& opts, size_t producers, size_t consumers)
+{
+    using Alloc = typename Policy::Alloc;
+    using Ring = leaky::PartsRing<uint8_t, Alloc>;
+
+    auto result = Result{};
+    auto policy = Policy(producers);
+    result.counters = policy.counters();
+    // Declared after the policy, so that any leftover parts are destroyed before its allocators
+    auto rings = std::vector<std::unique_ptr<Ring>>();
+    for (size_t i = 0; i < producers; i++)
+    {
+        rings.push_back(std::make_unique<Ring>(opts.ring));
+    }
+
+    auto leak_samples = std::vector<Samples>(producers);
+    auto reclaim_samples = std::vector<Samples>(consumers);
+    auto consumed = std::vector<size_t>(consumers, 0);
+    auto errors = std::vector<size_t>(consumers, 0);
+    std::atomic<bool> go{false};
+    std::atomic<size_t> producers_running{producers};
+
+    auto produce = [&](size_t p) {
+        const auto ops = opts.ops / producers + (p < opts.ops % producers ? 1 : 0);
+        auto& samples = leak_samples[p];
+        samples.reserve(ops);
+        auto& ring = *rings[p];
+        while (!go.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+
+        for (size_t i = 0; i < ops; i++)
+        {
+            const auto start = Clock::now();
+            auto vec = policy.make(p, opts.size);
+            const auto tag = static_cast<uint8_t>(p * 131 + i);
+            vec.front() = tag;
+            vec.back() = tag;
+            auto parts = leaky::Vec<uint8_t, Alloc>(std::move(vec)).leak();
+            samples.push_back(elapsed_ns(start));
+
+            // A failed push doesn't move from the parts
+            while (!ring.try_push(std::move(parts)))
+            {
+                std::this_thread::yield();
+            }
+        }
+        producers_running.fetch_sub(1, std::memory_order_release);
+    };
+
+    auto consume = [&](size_t c) {
+        // Pop a batch from each ring in turn, starting from a different ring on every consumer
+        constexpr size_t batch = 64;
+        auto& samples = reclaim_samples[c];
+        samples.reserve(opts.ops / consumers + 1);
+        while (!go.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+
+        while (true)
+        {
+            // Read before sweeping, so that a finished sweep that finds nothing is the last one
+            const bool finished = producers_running.load(std::memory_order_acquire) == 0;
+            size_t popped = 0;
+            for (size_t r = 0; r < producers; r++)
+            {
+                const auto p = (c + r) % producers;
+                for (size_t i = 0; i < batch; i++)
+                {
+                    auto parts = rings[p]->try_pop();
+                    if (!parts)
+                    {
+                        break;
+                    }
+                    const auto start = Clock::now();
+                    const auto* data = std::get<0>(*parts);
+                    const auto size = std::get<1>(*parts);
+                    if (size != opts.size || data[0] != data[size - 1])
+                    {
+                        errors[c]++;
+                    }
+                    policy.reclaim(p, std::move(*parts));
+                    samples.push_back(elapsed_ns(start));
+                    popped++;
+                }
+            }
+            consumed[c] += popped;
+            if (popped == 0)
+            {
+                if (finished)
+                {
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    auto threads = std::vector<std::thread>();
+    for (size_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back(produce, p);
+    }
+    for (size_t c = 0; c < consumers; c++)
+    {
+        threads.emplace_back(consume, c);
+    }
+    const auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (auto& samples : leak_samples)
+    {
+        result.leak.insert(result.leak.end(), samples.begin(), samples.end());
+    }
+    for (size_t c = 0; c < consumers; c++)
+    {
+        result.reclaim.insert(
+            result.reclaim.end(), reclaim_samples[c].begin(), reclaim_samples[c].end());
+        result.ops += consumed[c];
+        result.errors += errors[c];
+    }
+    return result;
+}
+
+/// @brief The `q`-th quantile of the samples, which are reordered
+uint32_t quantile(Samples& samples, double q)
+{
+    if (samples.empty())
+    {
+        return 0;
+    }
+    const auto nth = samples.begin() + static_cast<ptrdiff_t>(q * (samples.size() - 1));
+    std::nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+}
+
+void print_header()
+{
+    std::printf("%-9s %5s %5s %10s %8s %12s %9s %9s %9s %9s %10s %10s\n",
+                "allocator",
+                "prod",
+                "cons",
+                "ops",
+                "seconds",
+                "ops/sec",
+                "leak p50",
+                "leak p99",
+                "recl p50",
+                "recl p99",
+                "allocs",
+                "deallocs");
+}
+
+/// @brief Run and report one configuration
+///
+/// @return whether every vector was handed over intact
+template<typename Policy>
+bool report(const Options& opts, size_t producers, size_t consumers)
+{
+    auto result = run<Policy>(opts, producers, consumers);
+    // Read the counters once the policy is gone, so that the pools' blocks are counted as freed
+    const auto allocs = result.counters ? std::to_string(result.counters->allocations()) : "-";
+    const auto deallocs = result.counters ? std::to_string(result.counters->deallocations()) : "-";
+    std::printf("%-9s %5zu %5zu %10zu %8.3f %12.0f %9u %9u %9u %9u %10s %10s\n",
+                Policy::name,
+                producers,
+                consumers,
+                result.ops,
+                result.seconds,
+                static_cast<double>(result.ops) / result.seconds,
+                quantile(result.leak, 0.5),
+                quantile(result.leak, 0.99),
+                quantile(result.reclaim, 0.5),
+                quantile(result.reclaim, 0.99),
+                allocs.c_str(),
+                deallocs.c_str());
+    std::fflush(stdout);
+
+    if (result.ops != opts.ops || result.errors != 0)
+    {
+        std::fprintf(stderr,
+                     "%s: %zu of %zu vectors arrived, %zu corrupted\n",
+                     Policy::name,
+                     result.ops,
+                     opts.ops,
+                     result.errors);
+        return false;
+    }
+    return true;
+}
+
+bool report_all(const Options& opts, size_t producers, size_t consumers)
+{
+    bool ok = true;
+    const auto& name = opts.allocator;
+    if (name == "all" || name == DefaultPolicy::name)
+    {
+        ok &= report<DefaultPolicy>(opts, producers, consumers);
+    }
+    if (name == "all" || name == StatefulPolicy::name)
+    {
+        ok &= report<StatefulPolicy>(opts, producers, consumers);
+    }
+    if (name == "all" || name == PoolPolicy::name)
+    {
+        ok &= report<PoolPolicy>(opts, producers, consumers);
+    }
+    if (name == "all" || name == ArenaPolicy::name)
+    {
+        ok &= report<ArenaPolicy>(opts, producers, consumers);
+    }
+    return ok;
+}
+
+void usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [--producers N] [--consumers M] [--sweep MAX] [--ops OPS]\n"
+                 "          [--size BYTES] [--ring CAPACITY]\n"
+                 "          [--allocator default|stateful|pool|arena|all]\n"
+                 "\n"
+                 "  --sweep MAX  run with 1, 2, 4, ... up to MAX producers and as many consumers\n"
+                 "  --ops OPS    the total number of vectors, split between the producers\n"
+                 "\n"
+                 "The arena allocator never frees, so it uses OPS * BYTES bytes of memory.\n",
+                 program);
+}
+
+bool parse_size(const char* arg, size_t& out)
+{
+    char* end = nullptr;
+    const auto value = std::strtoull(arg, &end, 10);
+    if (end == arg || *end != '\0')
+    {
+        return false;
+    }
+    out = static_cast<size_t>(value);
+    return true;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    auto opts = Options{};
+    for (int i = 1; i < argc; i++)
+    {
+        const auto* flag = argv[i];
+        const auto* value = i + 1 < argc ? argv[++i] : nullptr;
+        bool ok = value != nullptr;
+        if (ok && std::strcmp(flag, "--allocator") == 0)
+        {
+            opts.allocator = value;
+            ok = opts.allocator == "all" || opts.allocator == DefaultPolicy::name ||
+                 opts.allocator == StatefulPolicy::name || opts.allocator == PoolPolicy::name ||
+                 opts.allocator == ArenaPolicy::name;
+        } else if (ok && std::strcmp(flag, "--producers") == 0)
+        {
+            ok = parse_size(value, opts.producers) && opts.producers > 0;
+        } else if (ok && std::strcmp(flag, "--consumers") == 0)
+        {
+            ok = parse_size(value, opts.consumers) && opts.consumers > 0;
+        } else if (ok && std::strcmp(flag, "--sweep") == 0)
+        {
+            ok = parse_size(value, opts.sweep) && opts.sweep > 0;
+        } else if (ok && std::strcmp(flag, "--ops") == 0)
+        {
+            ok = parse_size(value, opts.ops);
+        } else if (ok && std::strcmp(flag, "--size") == 0)
+        {
+            // Every vector needs a byte to tag
+            ok = parse_size(value, opts.size) && opts.size > 0;
+        } else if (ok && std::strcmp(flag, "--ring") == 0)
+        {
+            ok = parse_size(value, opts.ring) && opts.ring > 0;
+        } else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    print_header();
+    bool ok = true;
+    if (opts.sweep > 0)
+    {
+        for (size_t threads = 1; threads <= opts.sweep; threads *= 2)
+        {
+            ok &= report_all(opts, threads, threads);
+        }
+    } else
+    {
+        ok = report_all(opts, opts.producers, opts.consumers);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
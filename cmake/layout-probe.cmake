@@ -0,0 +1,52 @@
+# Probe the std::vector layout of the standard library at configure time, and generate
+# leakyvec/config.hpp from it. When the probe can't run, e.g., when cross-compiling without an
+# emulator, no config is generated, and leakyvec.hpp falls back to its built-in layouts.
+
+if(CMAKE_CROSSCOMPILING AND NOT CMAKE_CROSSCOMPILING_EMULATOR)
+    message(STATUS "Cross-compiling: using the built-in std::vector layouts")
+    return()
+endif()
+
+try_run(
+    LEAKY_PROBE_RUN_RESULT LEAKY_PROBE_COMPILE_RESULT ${CMAKE_CURRENT_BINARY_DIR}/layout-probe
+    ${CMAKE_CURRENT_LIST_DIR}/layout-probe.cpp
+    CXX_STANDARD 17
+    CXX_STANDARD_REQUIRED ON
+    COMPILE_OUTPUT_VARIABLE LEAKY_PROBE_COMPILE_OUTPUT
+    RUN_OUTPUT_VARIABLE LEAKY_PROBE_OUTPUT
+)
+
+if(NOT LEAKY_PROBE_COMPILE_RESULT)
+    message(WARNING "Failed to compile the std::vector layout probe:\n${LEAKY_PROBE_COMPILE_OUTPUT}")
+    return()
+endif()
+if(NOT LEAKY_PROBE_RUN_RESULT EQUAL 0)
+    message(WARNING "The std::vector layout probe failed: ${LEAKY_PROBE_OUTPUT}")
+    return()
+endif()
+
+list(GET LEAKY_PROBE_OUTPUT 0 LEAKY_PROBED_START)
+list(GET LEAKY_PROBE_OUTPUT 1 LEAKY_PROBED_FINISH)
+list(GET LEAKY_PROBE_OUTPUT 2 LEAKY_PROBED_END)
+list(GET LEAKY_PROBE_OUTPUT 3 LEAKY_PROBED_SHIFT)
+list(GET LEAKY_PROBE_OUTPUT 4 LEAKY_PROBED_WORDS)
+list(GET LEAKY_PROBE_OUTPUT 5 LEAKY_PROBED_STDLIB_MACRO)
+list(GET LEAKY_PROBE_OUTPUT 6 LEAKY_PROBED_STDLIB_VERSION)
+if(LEAKY_PROBED_SHIFT)
+    set(LEAKY_PROBED_ALLOCATOR_FIRST true)
+else()
+    set(LEAKY_PROBED_ALLOCATOR_FIRST false)
+endif()
+message(
+    STATUS
+        "Probed std::vector layout of ${LEAKY_PROBED_STDLIB_MACRO} ${LEAKY_PROBED_STDLIB_VERSION}: pointers at words ${LEAKY_PROBED_START}, ${LEAKY_PROBED_FINISH}, ${LEAKY_PROBED_END}"
+)
+
+set(LEAKY_GENERATED_INCLUDE_DIR ${CMAKE_CURRENT_BINARY_DIR}/generated/include)
+configure_file(
+    ${CMAKE_CURRENT_LIST_DIR}/config.hpp.in ${LEAKY_GENERATED_INCLUDE_DIR}/leakyvec/config.hpp @ONLY
+)
+target_include_directories(leakyvec INTERFACE $<BUILD_INTERFACE:${LEAKY_GENERATED_INCLUDE_DIR}>)
+install(FILES ${LEAKY_GENERATED_INCLUDE_DIR}/leakyvec/config.hpp
+        DESTINATION ${CMAKE_INSTALL_INCLUDEDIR}/leakyvec
+)
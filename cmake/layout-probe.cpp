@@ -0,0 +1,133 @@
+// Find where std::vector stores its start, finish, and end-of-storage pointers, by looking for
+// their values among the words of a vector. This runs at configure time, and prints the offsets,
+// in words, as a CMake list, followed by the standard library's identifying macro and its value.
+// See cmake/config.hpp.in.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// The macro that identifies the standard library, and whose value is its version
+#if defined(_LIBCPP_VERSION)
+    #define LEAKY_PROBE_STDLIB_MACRO "_LIBCPP_VERSION"
+    #define LEAKY_PROBE_STDLIB_VERSION _LIBCPP_VERSION
+#elif defined(__GLIBCXX__)
+    #define LEAKY_PROBE_STDLIB_MACRO "__GLIBCXX__"
+    #define LEAKY_PROBE_STDLIB_VERSION __GLIBCXX__
+#elif defined(_MSVC_STL_VERSION)
+    #define LEAKY_PROBE_STDLIB_MACRO "_MSVC_STL_VERSION"
+    #define LEAKY_PROBE_STDLIB_VERSION _MSVC_STL_VERSION
+#else
+    #error "Unsupported standard library"
+#endif
+
+namespace {
+
+/// An allocator that's stored in the vector, to find out whether it comes before the pointers
+template<typename T>
+struct StatefulAllocator
+{
+    using value_type = T;
+    const void* state;
+
+    explicit StatefulAllocator(const void* state) noexcept : state(state) {}
+    template<typename U>
+    StatefulAllocator(const StatefulAllocator<U>& other) noexcept : state(other.state)
+    {
+    }
+
+    T* allocate(size_t n) { return std::allocator<T>().allocate(n); }
+    void deallocate(T* p, size_t n) noexcept { std::allocator<T>().deallocate(p, n); }
+};
+
+template<typename T, typename U>
+bool operator==(const StatefulAllocator<T>& lhs, const StatefulAllocator<U>& rhs) noexcept
+{
+    return lhs.state == rhs.state;
+}
+
+template<typename T, typename U>
+bool operator!=(const StatefulAllocator<T>& lhs, const StatefulAllocator<U>& rhs) noexcept
+{
+    return lhs.state != rhs.state;
+}
+
+/// The word offset of the only word of `vec` equal to `value`, or -1
+template<typename Vector>
+int find_word(const Vector& vec, const void* value)
+{
+    constexpr size_t word_count = sizeof(Vector) / sizeof(void*);
+    const void* words[word_count];
+    std::memcpy(static_cast<void*>(words), static_cast<const void*>(&vec), sizeof(words));
+
+    int offset = -1;
+    for (size_t i = 0; i < word_count; i++)
+    {
+        if (words[i] == value)
+        {
+            if (offset != -1)
+            {
+                return -1;
+            }
+            offset = static_cast<int>(i);
+        }
+    }
+    return offset;
+}
+
+/// Find the offsets of the start, finish, and end-of-storage pointers
+template<typename Vector>
+bool probe(Vector& vec, int (&offsets)[3])
+{
+    vec.reserve(8);
+    vec.push_back(1);
+    vec.push_back(2);
+    vec.push_back(3);
+    offsets[0] = find_word(vec, vec.data());
+    offsets[1] = find_word(vec, vec.data() + vec.size());
+    offsets[2] = find_word(vec, vec.data() + vec.capacity());
+    return offsets[0] >= 0 && offsets[1] >= 0 && offsets[2] >= 0 &&
+           sizeof(Vector) % sizeof(void*) == 0;
+}
+}  // namespace
+
+int main()
+{
+    int offsets[3];
+    auto vec = std::vector<int>();
+    if (!probe(vec, offsets))
+    {
+        std::fprintf(stderr, "Can't find the std::vector<int> pointers\n");
+        return 1;
+    }
+
+    int stateful_offsets[3];
+    static const int state = 0;
+    auto stateful_vec = std::vector<int, StatefulAllocator<int>>(StatefulAllocator<int>(&state));
+    if (!probe(stateful_vec, stateful_offsets))
+    {
+        std::fprintf(stderr, "Can't find the std::vector<int, StatefulAllocator<int>> pointers\n");
+        return 1;
+    }
+
+    // A stateful allocator either shifts all three pointers by its size, or none of them
+    const int shift = stateful_offsets[0] - offsets[0];
+    if ((shift != 0 && shift != 1) || stateful_offsets[1] - offsets[1] != shift ||
+        stateful_offsets[2] - offsets[2] != shift)
+    {
+        std::fprintf(stderr, "A stateful allocator moves the std::vector pointers unexpectedly\n");
+        return 1;
+    }
+
+    std::printf("%d;%d;%d;%d;%zu;%s;%lld",
+                offsets[0],
+                offsets[1],
+                offsets[2],
+                shift,
+                sizeof(std::vector<int>) / sizeof(void*),
+                LEAKY_PROBE_STDLIB_MACRO,
+                static_cast<long long>(LEAKY_PROBE_STDLIB_VERSION));
+    return 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+namespace leaky {
+
+/// @brief A stateless allocator of memory blocks aligned to, and padded to a multiple of,
+/// `Alignment` bytes
+///
+/// This is meant for vectors consumed by SIMD kernels, e.g., `AlignedAllocator<float, 64>` for
+/// AVX-512. Every block starts on an `Alignment` boundary, and its size is rounded up to a multiple
+/// of `Alignment`, so a kernel can process the whole block with aligned loads and no scalar tail.
+/// `leaky::Vec` reports that padded capacity in its leaked parts (see `usable_capacity()`), and
+/// reports the alignment in `leaky_raw_parts::align`.
+///
+/// Blocks are allocated with `std::aligned_alloc`, so they can be freed with `free()`, and so by
+/// Rust's `std::alloc::System` on POSIX platforms.
+///
+/// @note The padding past the vector's size is uninitialized.
+/// @note MSVC doesn't provide `std::aligned_alloc`, so this isn't supported on Windows.
+///
+/// @tparam T the element type
+/// @tparam Alignment the alignment in bytes, a power of two at least as large as `alignof(T)`
+template<typename T, std::size_t Alignment = 64>
+struct AlignedAllocator
+{
+    static_assert(Alignment != 0 && (Alignment & (Alignment - 1)) == 0,
+                  "The alignment must be a power of two");
+    static_assert(Alignment >= alignof(T), "The alignment can't be smaller than alignof(T)");
+
+    using value_type = T;
+    static constexpr std::size_t alignment = Alignment;
+
+    // allocator_traits can't rebind an allocator with a non-type template parameter
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+    template<typename U>
+    constexpr AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
+    {
+    }
+
+    /// @brief The number of elements that fit in the padded block allocated for `n` elements
+    [[nodiscard]] static constexpr std::size_t padded_capacity(std::size_t n) noexcept
+    {
+        return (n * sizeof(T) + Alignment - 1) / Alignment * Alignment / sizeof(T);
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        if (n > (std::numeric_limits<std::size_t>::max() - Alignment) / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+
+        // std::aligned_alloc requires the size to be a multiple of the alignment
+        const auto bytes = (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+        void* p = std::aligned_alloc(Alignment, bytes == 0 ? Alignment : bytes);
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t /*n*/) noexcept { std::free(p); }
+
+    /// @brief The capacity of a block allocated for `n` elements, including its padding
+    [[nodiscard]] std::size_t usable_capacity(T* /*p*/, std::size_t n) const noexcept
+    {
+        return padded_capacity(n);
+    }
+};
+
+template<class T, class U, std::size_t Alignment>
+constexpr bool operator==(const AlignedAllocator<T, Alignment>&,
+                          const AlignedAllocator<U, Alignment>&) noexcept
+{
+    return true;
+}
+
+template<class T, class U, std::size_t Alignment>
+constexpr bool operator!=(const AlignedAllocator<T, Alignment>&,
+                          const AlignedAllocator<U, Alignment>&) noexcept
+{
+    return false;
+}
+}  // namespace leaky
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+namespace leaky {
+
+/// @brief A monotonic arena that frees everything allocated from it at once
+///
+/// Memory is handed out from large blocks by bumping a pointer, and is only given back when the
+/// arena is released or destroyed. It is not thread-safe.
+using Arena = std::pmr::monotonic_buffer_resource;
+
+/// @brief A stateful allocator that allocates from a monotonic Arena
+///
+/// The allocator is just a handle to its arena, so it's as cheap to copy as a pointer, and the
+/// allocator part of `leaky::Vec::leak()` tells the receiver which arena the memory belongs to.
+///
+/// Deallocating is a no-op; the memory is reclaimed all at once by `Arena::release()`, or by
+/// destroying the arena. That makes it safe to leak vectors allocated from an arena and never
+/// reconstruct them, as long as nobody touches their memory after the arena is released.
+///
+/// @note The arena must outlive every allocator and vector that refers to it.
+template<typename T>
+class ArenaAllocator
+{
+  private:
+    Arena* m_arena;
+
+    template<typename U>
+    friend class ArenaAllocator;
+
+  public:
+    using value_type = T;
+    // The arena goes wherever the memory goes
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    explicit ArenaAllocator(Arena& arena) noexcept : m_arena(&arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.m_arena)
+    {
+    }
+
+    /// @brief Get the arena that owns this allocator's memory
+    [[nodiscard]] Arena& arena() const noexcept { return *m_arena; }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /// @brief A no-op; the memory is freed when the arena is released
+    void deallocate(T* /*p*/, std::size_t /*n*/) noexcept {}
+
+    template<class U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept
+    {
+        return m_arena == other.m_arena;
+    }
+
+    template<class U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept
+    {
+        return m_arena != other.m_arena;
+    }
+};
+}  // namespace leaky
@@ -0,0 +1,155 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+
+// The Arrow C data interface structs, as specified in
+// https://arrow.apache.org/docs/format/CDataInterface.html. They're ABI-stable, so any producer or
+// consumer that defines them is compatible, and the guard lets this header coexist with Arrow's own
+// headers without depending on them.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+struct ArrowSchema
+{
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray
+{
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+}  // extern "C"
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+namespace leaky {
+namespace detail {
+    /// @brief The Arrow format string of a primitive type, or nullptr if it has none
+    template<typename T>
+    constexpr const char* arrow_format() noexcept
+    {
+        if constexpr (std::is_same_v<T, float>)
+        {
+            return "f";
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            return "g";
+        }
+        else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+        {
+            // Arrow's integer types are identified by their width and signedness only
+            constexpr const char* signed_formats[] = {"c", "s", nullptr, "i", nullptr, nullptr,
+                                                      nullptr, "l"};
+            constexpr const char* unsigned_formats[] = {"C", "S", nullptr, "I", nullptr, nullptr,
+                                                        nullptr, "L"};
+            return std::is_signed_v<T> ? signed_formats[sizeof(T) - 1]
+                                       : unsigned_formats[sizeof(T) - 1];
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    /// @brief The state owned by an exported ArrowArray, freed by its release callback
+    template<typename T, typename Alloc>
+    struct ArrowPrivateData
+    {
+        std::tuple<typename std::vector<T, Alloc>::pointer, size_t, size_t, Alloc> parts;
+        const void* buffers[2];
+    };
+
+    template<typename T, typename Alloc>
+    void release_arrow_array(ArrowArray* array) noexcept
+    {
+        auto private_data = std::unique_ptr<ArrowPrivateData<T, Alloc>>(
+            static_cast<ArrowPrivateData<T, Alloc>*>(array->private_data));
+        static_cast<void>(Vec<T, Alloc>::from_parts(std::move(private_data->parts)).take());
+        array->release = nullptr;
+    }
+
+    inline void release_arrow_schema(ArrowSchema* schema) noexcept { schema->release = nullptr; }
+}  // namespace detail
+
+/// @brief Whether a vector of `T` can be exported as an Arrow primitive array
+template<typename T>
+inline constexpr bool is_arrow_primitive_v = detail::arrow_format<T>() != nullptr;
+
+/// @brief Leak a vector into an Arrow array and its schema, without copying its elements
+///
+/// The vector's data block becomes the array's values buffer. The array has no validity buffer, so
+/// it has no nulls, and the schema is unnamed and non-nullable. Once the consumer calls the array's
+/// release callback, the vector is reconstructed with `from_parts()` and destroyed, which frees
+/// the data block with the vector's own allocator. The schema owns no memory, and may be released
+/// independently of the array.
+///
+/// @note Arrow only requires buffers to be aligned to their element type, but recommends 64 byte
+///       alignment. Some consumers copy buffers that aren't aligned to 8 or 64 bytes.
+/// @note After calling this function, the vector is left in an empty state.
+///
+/// @throws std::bad_alloc if the array's private data can't be allocated, in which case the vector
+///         is left unchanged.
+template<typename T, typename Alloc>
+void leak_to_arrow(Vec<T, Alloc>& vec, ArrowArray* out_array, ArrowSchema* out_schema)
+{
+    static_assert(is_arrow_primitive_v<T>,
+                  "Only vectors of integers, float, or double can be exported to Arrow");
+    LEAKY_DEBUG_ASSERT(vec.as_ref().size() <=
+                       static_cast<size_t>(std::numeric_limits<int64_t>::max()));
+
+    // The private data is allocated before the vector is leaked, so throwing leaves it unchanged
+    auto private_data = std::unique_ptr<detail::ArrowPrivateData<T, Alloc>>(
+        new detail::ArrowPrivateData<T, Alloc>{vec.leak(), {nullptr, nullptr}});
+    private_data->buffers[1] = static_cast<const void*>(std::get<0>(private_data->parts));
+
+    *out_array = ArrowArray{static_cast<int64_t>(std::get<1>(private_data->parts)),
+                            0,
+                            0,
+                            2,
+                            0,
+                            private_data->buffers,
+                            nullptr,
+                            nullptr,
+                            &detail::release_arrow_array<T, Alloc>,
+                            private_data.release()};
+    *out_schema = ArrowSchema{detail::arrow_format<T>(),
+                              nullptr,
+                              nullptr,
+                              0,
+                              0,
+                              nullptr,
+                              nullptr,
+                              &detail::release_arrow_schema,
+                              nullptr};
+}
+}  // namespace leaky
@@ -0,0 +1,127 @@
+#pragma once
+#include "ffi.h"
+#include "leakyvec.hpp"
+
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace leaky {
+
+/// @brief The raw parts of a batch of leaked vectors, as a structure-of-arrays
+///
+/// The i-th element of `ptrs`, `lens`, and `caps` describes the i-th leaked vector. Like
+/// `leaky_raw_parts`, this doesn't carry the allocators, so it's only available for stateless
+/// allocators.
+///
+/// @tparam T the element type
+/// @tparam Alloc the allocator type
+template<typename T, typename Alloc = typename std::vector<T>::allocator_type>
+struct BatchParts
+{
+    using pointer = typename std::vector<T, Alloc>::pointer;
+    static_assert(std::allocator_traits<Alloc>::is_always_equal::value,
+                  "Only vectors with stateless allocators can be leaked in a batch");
+
+    std::vector<void*> ptrs;
+    std::vector<size_t> lens;
+    std::vector<size_t> caps;
+
+    [[nodiscard]] size_t size() const noexcept { return ptrs.size(); }
+    [[nodiscard]] bool empty() const noexcept { return ptrs.empty(); }
+
+    /// @brief Forget the parts, without freeing any of them, but keep the arrays' capacity
+    void clear() noexcept
+    {
+        ptrs.clear();
+        lens.clear();
+        caps.clear();
+    }
+
+    /// @brief Get a C ABI view of the batch
+    ///
+    /// @note The view borrows this batch's arrays, and is invalidated when the batch is modified.
+    [[nodiscard]] leaky_raw_parts_batch as_c() noexcept
+    {
+        constexpr size_t align = detail::alloc_alignment<T, Alloc>::value;
+        return leaky_raw_parts_batch{
+            ptrs.data(), lens.data(), caps.data(), ptrs.size(), sizeof(T), align};
+    }
+};
+
+/// @brief Leak every std::vector in a range into a batch of raw parts
+///
+/// The parts are appended to `batch`, so a batch can be cleared and reused to avoid reallocating
+/// its arrays.
+///
+/// @note After calling this function, each std::vector in the range is left in an empty state.
+template<typename Range,
+         typename Vector = std::remove_reference_t<decltype(*std::begin(std::declval<Range&>()))>,
+         typename T = typename Vector::value_type,
+         typename Alloc = typename Vector::allocator_type>
+void leak_all(Range& vecs, BatchParts<T, Alloc>& batch)
+{
+    const auto count = static_cast<size_t>(std::distance(std::begin(vecs), std::end(vecs)));
+    batch.ptrs.reserve(batch.size() + count);
+    batch.lens.reserve(batch.size() + count);
+    batch.caps.reserve(batch.size() + count);
+
+    for (auto& vec : vecs)
+    {
+        auto [data, size, capacity, alloc] = Vec<T, Alloc>(std::move(vec)).leak();
+        static_cast<void>(alloc);
+        batch.ptrs.push_back(static_cast<void*>(data));
+        batch.lens.push_back(size);
+        batch.caps.push_back(capacity);
+    }
+}
+
+/// @brief Leak every std::vector in a range into a new batch of raw parts
+///
+/// @note After calling this function, each std::vector in the range is left in an empty state.
+template<typename Range,
+         typename Vector = std::remove_reference_t<decltype(*std::begin(std::declval<Range&>()))>,
+         typename T = typename Vector::value_type,
+         typename Alloc = typename Vector::allocator_type>
+[[nodiscard]] BatchParts<T, Alloc> leak_all(Range& vecs)
+{
+    BatchParts<T, Alloc> batch;
+    leak_all(vecs, batch);
+    return batch;
+}
+
+/// @brief Reconstruct every std::vector from a C ABI batch of raw parts
+///
+/// The vectors are appended to `out`.
+///
+/// @note The element size and alignment of the batch must match `T`.
+template<typename T, typename Alloc>
+void from_parts_all(const leaky_raw_parts_batch& batch,
+                    std::vector<std::vector<T, Alloc>>& out,
+                    const Alloc& alloc = Alloc())
+{
+    LEAKY_DEBUG_ASSERT(batch.elem_size == sizeof(T));
+    LEAKY_DEBUG_ASSERT(batch.align == (detail::alloc_alignment<T, Alloc>::value));
+
+    out.reserve(out.size() + batch.count);
+    for (size_t i = 0; i < batch.count; i++)
+    {
+        const leaky_raw_parts parts{
+            batch.ptrs[i], batch.lens[i], batch.caps[i], batch.elem_size, batch.align};
+        out.push_back(Vec<T, Alloc>::from_c(parts, alloc).take());
+    }
+}
+
+/// @brief Reconstruct every std::vector from a batch of raw parts returned by `leak_all()`
+///
+/// @note The batch is left empty.
+template<typename T, typename Alloc>
+[[nodiscard]] std::vector<std::vector<T, Alloc>> from_parts_all(BatchParts<T, Alloc>& batch)
+{
+    std::vector<std::vector<T, Alloc>> out;
+    from_parts_all(batch.as_c(), out);
+    batch.clear();
+    return out;
+}
+}  // namespace leaky
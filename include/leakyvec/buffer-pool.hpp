@@ -0,0 +1,169 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <vector>
+
+namespace leaky {
+
+/// @brief A pool that recycles the memory blocks of reclaimed vectors, bucketed by capacity
+///
+/// Each bucket holds the blocks whose capacity is in `[2^i, 2^(i+1))`, so a block from bucket
+/// `ceil(log2(n))` can always hold `n` elements. The free lists are intrusive: a recycled block
+/// stores its own list node, so recycling never allocates. Blocks too small or misaligned to hold
+/// a node are deallocated instead.
+///
+/// The pool is meant to be owned by a single producer thread, e.g., as a `thread_local`. Only that
+/// thread may call `acquire()` and `trim()`, but any thread may `recycle()` blocks concurrently,
+/// without locking. Because only the owner pops from the free lists, they don't suffer from the ABA
+/// problem.
+///
+/// @tparam T the element type
+/// @tparam Alloc the allocator type. Every recycled block must have been allocated by an allocator
+///               that compares equal to the pool's. The pool's allocator deallocates blocks from
+///               any thread that recycles them, so it must be thread-safe.
+template<typename T, typename Alloc = typename std::vector<T>::allocator_type>
+class BufferPool
+{
+  public:
+    using pointer = typename std::vector<T, Alloc>::pointer;
+    static constexpr size_t bucket_count = sizeof(size_t) * 8;
+
+  private:
+    struct Node
+    {
+        Node* next;
+        size_t capacity;
+    };
+
+    Alloc m_alloc;
+    std::array<std::atomic<Node*>, bucket_count> m_buckets{};
+
+    /// @brief floor(log2(n)), for n > 0
+    static size_t floor_log2(size_t n) noexcept
+    {
+        size_t log2 = 0;
+        while (n >>= 1)
+        {
+            log2++;
+        }
+        return log2;
+    }
+
+    /// @brief ceil(log2(n)), for n > 0
+    static size_t ceil_log2(size_t n) noexcept { return n == 1 ? 0 : floor_log2(n - 1) + 1; }
+
+    /// @brief Deallocate a block that was leaked into the pool
+    void deallocate(pointer data, size_t capacity) noexcept
+    {
+        LEAKY_LEDGER_RECLAIM(T, data, capacity);
+        std::allocator_traits<Alloc>::deallocate(m_alloc, data, capacity);
+    }
+
+  public:
+    explicit BufferPool(const Alloc& alloc = Alloc()) noexcept : m_alloc(alloc) {}
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+    ~BufferPool() noexcept { trim(); }
+
+    [[nodiscard]] const Alloc& get_allocator() const noexcept { return m_alloc; }
+
+    /// @brief Get an empty vector with a capacity of at least `capacity` elements
+    ///
+    /// The vector reuses a recycled block when one is large enough, and otherwise allocates a new
+    /// block with a power-of-two capacity, so that it lands in the same bucket when it's recycled.
+    /// Only the pool's owner thread may call this method.
+    ///
+    /// @throws std::bad_alloc if the allocator fails
+    [[nodiscard]] std::vector<T, Alloc> acquire(size_t capacity)
+    {
+        const auto bucket = ceil_log2(capacity == 0 ? 1 : capacity);
+        for (auto i = bucket; i < bucket_count; i++)
+        {
+            Node* node = m_buckets[i].load(std::memory_order_acquire);
+            while (node != nullptr &&
+                   !m_buckets[i].compare_exchange_weak(
+                       node, node->next, std::memory_order_acquire, std::memory_order_acquire))
+            {
+            }
+            if (node != nullptr)
+            {
+                const auto node_capacity = node->capacity;
+                node->~Node();
+                auto parts = std::tuple<pointer, size_t, size_t, Alloc>{
+                    reinterpret_cast<pointer>(node), 0, node_capacity, m_alloc};
+                return Vec<T, Alloc>::from_parts(std::move(parts)).take();
+            }
+
+            // Only look one bucket up, so that small requests don't hog large blocks
+            if (i > bucket)
+            {
+                break;
+            }
+        }
+
+        auto vec = std::vector<T, Alloc>(m_alloc);
+        vec.reserve(bucket < bucket_count ? size_t{1} << bucket : capacity);
+        return vec;
+    }
+
+    /// @brief Return a vector's memory block to the pool. Any thread may call this method.
+    ///
+    /// The vector's elements are destroyed, and it's left in an empty state.
+    void recycle(std::vector<T, Alloc>&& vec) noexcept
+    {
+        vec.clear();
+        auto [data, size, capacity, alloc] = Vec<T, Alloc>(std::move(vec)).leak();
+        static_cast<void>(size);
+        LEAKY_DEBUG_ASSERT(alloc == m_alloc);
+
+        if (data == nullptr)
+        {
+            return;
+        }
+        if (capacity * sizeof(T) < sizeof(Node) ||
+            reinterpret_cast<uintptr_t>(data) % alignof(Node) != 0)
+        {
+            deallocate(data, capacity);
+            return;
+        }
+
+        auto& head = m_buckets[floor_log2(capacity)];
+        Node* node = ::new (static_cast<void*>(data)) Node{head.load(std::memory_order_relaxed),
+                                                           capacity};
+        while (!head.compare_exchange_weak(
+            node->next, node, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /// @brief Return a vector's memory block to the pool, from its raw parts returned by `leak()`
+    void recycle(std::tuple<pointer, size_t, size_t, Alloc>&& parts) noexcept
+    {
+        recycle(Vec<T, Alloc>::from_parts(std::move(parts)).take());
+    }
+
+    /// @brief Deallocate every recycled block. Only the pool's owner thread may call this method.
+    void trim() noexcept
+    {
+        for (auto& bucket : m_buckets)
+        {
+            Node* node = bucket.exchange(nullptr, std::memory_order_acquire);
+            while (node != nullptr)
+            {
+                Node* next = node->next;
+                const auto capacity = node->capacity;
+                node->~Node();
+                deallocate(reinterpret_cast<pointer>(node), capacity);
+                node = next;
+            }
+        }
+    }
+};
+}  // namespace leaky
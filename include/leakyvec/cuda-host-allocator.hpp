@@ -0,0 +1,264 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <cuda_runtime_api.h>
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace leaky {
+
+/// @brief A stateless allocator of page-locked host memory, allocated with `cudaHostAlloc`
+///
+/// The GPU can DMA pinned memory directly, so a vector allocated with this allocator can be the
+/// source or destination of `cudaMemcpyAsync` as is, without a copy into a pinned staging buffer,
+/// and the copy is truly asynchronous. Pinned memory is a scarce, slow-to-allocate resource, so
+/// prefer recycling the blocks, e.g., with a `BufferPool`.
+///
+/// Blocks must be freed with `cudaFreeHost`, which synchronizes the device, and must not be freed
+/// before the copies reading them complete. Use `CudaHostReclaimer` to free blocks once a stream
+/// is done with them.
+///
+/// @note Building with this header requires the CUDA runtime (`-DLEAKY_WITH_CUDA=ON`).
+///
+/// @tparam T the element type
+/// @tparam Flags the `cudaHostAlloc` flags, e.g., `cudaHostAllocPortable` for memory that's
+///               pinned for every CUDA context, or `cudaHostAllocWriteCombined` for buffers that
+///               the host only writes
+template<typename T, unsigned int Flags = cudaHostAllocDefault>
+struct CudaHostAllocator
+{
+    using value_type = T;
+
+    // allocator_traits can't rebind an allocator with a non-type template parameter
+    template<typename U>
+    struct rebind
+    {
+        using other = CudaHostAllocator<U, Flags>;
+    };
+
+    CudaHostAllocator() noexcept = default;
+    template<typename U>
+    constexpr CudaHostAllocator(const CudaHostAllocator<U, Flags>&) noexcept
+    {
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        if (n == 0)
+        {
+            return nullptr;
+        }
+
+        void* p = nullptr;
+        if (cudaHostAlloc(&p, n * sizeof(T), Flags) != cudaSuccess)
+        {
+            // Clear the error, so that it isn't reported by an unrelated CUDA call
+            static_cast<void>(cudaGetLastError());
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t /*n*/) noexcept
+    {
+        if (p != nullptr)
+        {
+            static_cast<void>(cudaFreeHost(p));
+        }
+    }
+};
+
+template<class T, class U, unsigned int Flags>
+constexpr bool operator==(const CudaHostAllocator<T, Flags>&,
+                          const CudaHostAllocator<U, Flags>&) noexcept
+{
+    return true;
+}
+
+template<class T, class U, unsigned int Flags>
+constexpr bool operator!=(const CudaHostAllocator<T, Flags>&,
+                          const CudaHostAllocator<U, Flags>&) noexcept
+{
+    return false;
+}
+
+/// @brief Frees leaked pinned vectors once the work queued on a CUDA stream before them completes
+///
+/// `release()` records an event on the stream, and the vector is reconstructed and destroyed
+/// once that event completes, so the memory outlives any `cudaMemcpyAsync` queued before it. CUDA
+/// forbids calling `cudaFreeHost` from a stream callback (`cudaLaunchHostFunc`), so the released
+/// vectors are freed by `reclaim()`, which polls the events, or by `synchronize()`, which waits
+/// for them. The destructor waits for the remaining vectors.
+///
+/// `release_callback` matches `leaky_dealloc_fn`, with the reclaimer as its context, so a Rust or
+/// C consumer that's given a vector's `leaky_raw_parts` can release it after queuing its copies.
+///
+/// All methods are thread-safe.
+///
+/// @tparam T the element type
+/// @tparam Alloc the allocator type, e.g., `CudaHostAllocator<T>`
+template<typename T, typename Alloc = CudaHostAllocator<T>>
+class CudaHostReclaimer
+{
+  public:
+    using pointer = typename std::vector<T, Alloc>::pointer;
+    using parts_type = std::tuple<pointer, size_t, size_t, Alloc>;
+
+  private:
+    struct Pending
+    {
+        cudaEvent_t event;
+        parts_type parts;
+    };
+
+    cudaStream_t m_stream;
+    std::mutex m_mutex;
+    std::vector<Pending> m_pending;
+    // Completed events are reused, because creating one is much slower than recording it
+    std::vector<cudaEvent_t> m_free_events;
+
+    static void free_parts(parts_type&& parts) noexcept
+    {
+        static_cast<void>(Vec<T, Alloc>::from_parts(std::move(parts)).take());
+    }
+
+    /// @brief Free the pending vectors whose event completed, or all of them if `wait` is true
+    size_t reclaim_pending(bool wait) noexcept
+    {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        size_t reclaimed = 0;
+        for (size_t i = 0; i < m_pending.size();)
+        {
+            auto& pending = m_pending[i];
+            const auto status =
+                wait ? cudaEventSynchronize(pending.event) : cudaEventQuery(pending.event);
+            if (status == cudaErrorNotReady)
+            {
+                i++;
+                continue;
+            }
+
+            // On any other error, the event won't complete anymore, so the vector is freed anyway
+            free_parts(std::move(pending.parts));
+            try
+            {
+                m_free_events.push_back(pending.event);
+            } catch (const std::bad_alloc&)
+            {
+                static_cast<void>(cudaEventDestroy(pending.event));
+            }
+            if (i + 1 != m_pending.size())
+            {
+                pending = std::move(m_pending.back());
+            }
+            m_pending.pop_back();
+            reclaimed++;
+        }
+        return reclaimed;
+    }
+
+  public:
+    /// @brief Create a reclaimer for the vectors used by the work queued on `stream`
+    explicit CudaHostReclaimer(cudaStream_t stream) noexcept : m_stream(stream) {}
+    CudaHostReclaimer(const CudaHostReclaimer&) = delete;
+    CudaHostReclaimer& operator=(const CudaHostReclaimer&) = delete;
+
+    ~CudaHostReclaimer() noexcept
+    {
+        synchronize();
+        for (auto event : m_free_events)
+        {
+            static_cast<void>(cudaEventDestroy(event));
+        }
+    }
+
+    [[nodiscard]] cudaStream_t stream() const noexcept { return m_stream; }
+
+    /// @brief Free a leaked vector once the work queued on the stream so far completes
+    ///
+    /// If the event can't be created or recorded, this waits for the stream before freeing the
+    /// vector.
+    void release(parts_type&& parts) noexcept
+    {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        cudaEvent_t event = nullptr;
+        if (!m_free_events.empty())
+        {
+            event = m_free_events.back();
+            m_free_events.pop_back();
+        } else if (cudaEventCreateWithFlags(&event, cudaEventDisableTiming) != cudaSuccess)
+        {
+            event = nullptr;
+        }
+
+        if (event != nullptr && cudaEventRecord(event, m_stream) == cudaSuccess)
+        {
+            try
+            {
+                if (m_pending.size() == m_pending.capacity())
+                {
+                    m_pending.reserve(m_pending.empty() ? 8 : 2 * m_pending.size());
+                }
+                m_pending.push_back(Pending{event, std::move(parts)});
+                return;
+            } catch (const std::bad_alloc&)
+            {
+                // Reserving failed, so the parts weren't moved from
+            }
+        }
+
+        if (event != nullptr)
+        {
+            static_cast<void>(cudaEventDestroy(event));
+        }
+        static_cast<void>(cudaGetLastError());
+        lock.unlock();
+        static_cast<void>(cudaStreamSynchronize(m_stream));
+        free_parts(std::move(parts));
+    }
+
+    /// @brief Free a leaked vector from its C ABI parts, like `release()`
+    ///
+    /// This has the signature of `leaky_dealloc_fn`, and `ctx` must point to the reclaimer. It's
+    /// only available for stateless allocators, like `CudaHostAllocator`, and trivially
+    /// destructible types, since the callback isn't told how many elements to destroy.
+    static void release_callback(void* ctx, void* ptr, size_t cap) noexcept
+    {
+        static_assert(std::allocator_traits<Alloc>::is_always_equal::value,
+                      "Only vectors with stateless allocators can be released from C");
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "Only trivially destructible types can be released from C");
+        auto* reclaimer = static_cast<CudaHostReclaimer*>(ctx);
+        reclaimer->release(parts_type{static_cast<pointer>(ptr), 0, cap, Alloc()});
+    }
+
+    /// @brief Free the released vectors whose work completed, without blocking on the stream
+    ///
+    /// @return the number of vectors freed
+    size_t reclaim() noexcept { return reclaim_pending(false); }
+
+    /// @brief Wait for the work queued before every released vector, and free them
+    ///
+    /// @return the number of vectors freed
+    size_t synchronize() noexcept { return reclaim_pending(true); }
+
+    /// @brief The number of released vectors not freed yet
+    [[nodiscard]] size_t pending() noexcept
+    {
+        const auto lock = std::lock_guard<std::mutex>(m_mutex);
+        return m_pending.size();
+    }
+};
+}  // namespace leaky
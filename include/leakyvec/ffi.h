@@ -0,0 +1,54 @@
+/// @file ffi.h
+/// @brief A C ABI for handing leaked vectors across a language boundary
+///
+/// Everything in this header is plain C so that it can be consumed by `extern "C"` code and by
+/// other languages' FFI layers, e.g., a `#[repr(C)]` struct in Rust.
+#pragma once
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// @brief The raw parts of a leaked vector, with a fixed layout
+///
+/// Unlike the tuple returned by `leaky::Vec::leak()`, this does not carry the allocator, so it can
+/// only describe vectors whose allocator is stateless. The element size and alignment are carried
+/// along so that the receiving side can verify it's reconstructing the right element type.
+///
+/// An empty, never-allocated vector has a NULL `ptr`, and zero `len` and `cap`.
+typedef struct leaky_raw_parts
+{
+    void* ptr;         ///< pointer to the start of the vector's data block
+    size_t len;        ///< number of initialized elements
+    size_t cap;        ///< number of allocated elements
+    size_t elem_size;  ///< sizeof(T) in bytes
+    size_t align;      ///< alignment of the data block in bytes, alignof(T) or larger
+} leaky_raw_parts;
+
+/// @brief The raw parts of a batch of leaked vectors with the same element type, as a
+/// structure-of-arrays
+///
+/// Each of `ptrs`, `lens`, and `caps` points to an array of `count` elements, where the i-th
+/// element of each describes the i-th leaked vector, like the fields of `leaky_raw_parts`. The
+/// arrays themselves are owned by whoever built the batch, not by the receiver.
+typedef struct leaky_raw_parts_batch
+{
+    void** ptrs;       ///< pointers to the start of each vector's data block
+    size_t* lens;      ///< number of initialized elements in each vector
+    size_t* caps;      ///< number of allocated elements in each vector
+    size_t count;      ///< number of vectors in the batch
+    size_t elem_size;  ///< sizeof(T) in bytes
+    size_t align;      ///< alignment of the data block in bytes, alignof(T) or larger
+} leaky_raw_parts_batch;
+
+/// @brief A callback that frees a memory block of `cap` elements allocated by a foreign allocator
+///
+/// `ctx` is an opaque pointer given back to the callback, e.g., a pointer to the foreign
+/// allocator's state.
+typedef void (*leaky_dealloc_fn)(void* ctx, void* ptr, size_t cap);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
@@ -0,0 +1,392 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace leaky {
+
+/// @brief The header at the start of a file that backs a vector
+///
+/// The vector's data block starts `data_offset` bytes into the file, which is always a multiple of
+/// the page size so that the data block is page aligned.
+struct FileHeader
+{
+    static constexpr uint64_t expected_magic = 0x5645'4359'4b41'454c;  // "LEAKYCEV"
+
+    uint64_t magic;
+    uint64_t data_offset;  ///< offset of the data block in bytes
+    uint64_t len;          ///< number of initialized elements, as of the last `leak_to_file()`
+    uint64_t cap;          ///< number of allocated elements, as of the last `leak_to_file()`
+    uint64_t elem_size;    ///< sizeof(T) in bytes
+};
+
+template<typename T>
+class FileAllocator;
+
+/// @brief An open file that backs a vector's memory through shared mappings
+///
+/// Every block is mapped from its own page-aligned region of the file, after the header's page, so
+/// the blocks of a growing vector, or of a vector and its copy, never overlap. New regions are
+/// appended at the end of the file. Freeing a block unmaps it and punches its region out of the
+/// file, except for the block persisted by the last `leak_to_file()`, which keeps its contents.
+///
+/// The file descriptor is closed when the last FileAllocator referring to it is destroyed. The file
+/// itself is never deleted.
+class MappedFile
+{
+  private:
+    int m_fd;
+    std::string m_path;
+    std::mutex m_mutex;
+    /// The offset of the next region, at the end of the file
+    uint64_t m_end;
+    /// The offset of the region persisted in the header, or 0 if there's none
+    uint64_t m_persisted = 0;
+    /// The offset of every block mapped from the file
+    std::unordered_map<const void*, uint64_t> m_offsets;
+
+    template<typename T>
+    friend class FileAllocator;
+
+    template<typename T>
+    friend std::tuple<T*, size_t, size_t, FileAllocator<T>>
+    leak_to_file(Vec<T, FileAllocator<T>>& vec);
+
+    template<typename T>
+    friend std::tuple<T*, size_t, size_t, FileAllocator<T>>
+    parts_from_file(const std::string& path);
+
+    /// @brief Map `length` bytes at `offset`, and remember where the block came from
+    ///
+    /// @return the mapping, or nullptr if it failed
+    void* map_region(uint64_t offset, size_t length) noexcept
+    {
+        void* base = mmap(nullptr,
+                          length,
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED,
+                          m_fd,
+                          static_cast<off_t>(offset));
+        if (base == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        try
+        {
+            m_offsets.emplace(base, offset);
+        } catch (const std::bad_alloc&)
+        {
+            munmap(base, length);
+            return nullptr;
+        }
+        return base;
+    }
+
+    /// @brief Grow the file by a new region of `length` bytes, and map it
+    ///
+    /// @throws std::bad_alloc if the file can't be grown or mapped
+    void* allocate_region(size_t length)
+    {
+        const auto lock = std::lock_guard<std::mutex>(m_mutex);
+        const auto offset = m_end;
+        if (ftruncate(m_fd, static_cast<off_t>(offset + length)) != 0)
+        {
+            throw std::bad_alloc();
+        }
+        void* base = map_region(offset, length);
+        if (base == nullptr)
+        {
+            static_cast<void>(ftruncate(m_fd, static_cast<off_t>(offset)));
+            throw std::bad_alloc();
+        }
+        m_end = offset + length;
+        return base;
+    }
+
+    /// @brief Unmap a block, and free its region unless it's the persisted one
+    void deallocate_region(void* base, size_t length) noexcept
+    {
+        const auto lock = std::lock_guard<std::mutex>(m_mutex);
+        const auto it = m_offsets.find(base);
+        LEAKY_DEBUG_ASSERT(it != m_offsets.end());
+        if (it != m_offsets.end())
+        {
+            if (it->second != m_persisted)
+            {
+                static_cast<void>(fallocate(m_fd,
+                                            FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                                            static_cast<off_t>(it->second),
+                                            static_cast<off_t>(length)));
+            }
+            m_offsets.erase(it);
+        }
+        const int result = munmap(base, length);
+        LEAKY_DEBUG_ASSERT(result == 0);
+        static_cast<void>(result);
+    }
+
+    /// @brief The offset of a mapped block in the file
+    uint64_t offset_of(const void* base) noexcept
+    {
+        const auto lock = std::lock_guard<std::mutex>(m_mutex);
+        const auto it = m_offsets.find(base);
+        LEAKY_DEBUG_ASSERT(it != m_offsets.end());
+        return it == m_offsets.end() ? 0 : it->second;
+    }
+
+  public:
+    MappedFile(int fd, std::string path, uint64_t end) noexcept :
+        m_fd(fd), m_path(std::move(path)), m_end(end)
+    {
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() noexcept { ::close(m_fd); }
+
+    /// @brief Create a new file to back a vector, or truncate an existing one
+    ///
+    /// @throws std::system_error if the file can't be opened
+    static std::shared_ptr<MappedFile> create(const std::string& path)
+    {
+        return open_file(path, O_RDWR | O_CREAT | O_TRUNC);
+    }
+
+    /// @brief Open an existing file that backs a vector
+    ///
+    /// @throws std::system_error if the file can't be opened
+    static std::shared_ptr<MappedFile> open(const std::string& path)
+    {
+        return open_file(path, O_RDWR);
+    }
+
+    [[nodiscard]] int fd() const noexcept { return m_fd; }
+    [[nodiscard]] const std::string& path() const noexcept { return m_path; }
+
+    /// @brief The size of the header at the start of the file, in bytes: a whole page
+    [[nodiscard]] static size_t header_size() noexcept
+    {
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+  private:
+    static std::shared_ptr<MappedFile> open_file(const std::string& path, int flags)
+    {
+        const int fd = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+        struct stat file_stat = {};
+        if (fd < 0 || fstat(fd, &file_stat) != 0)
+        {
+            const auto error = errno;
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+            throw std::system_error(error, std::generic_category(), path);
+        }
+
+        // Append new regions after whatever the file holds already
+        const auto page = header_size();
+        auto end = (static_cast<uint64_t>(file_stat.st_size) + page - 1) / page * page;
+        end = end < page ? page : end;
+        try
+        {
+            return std::make_shared<MappedFile>(fd, path, end);
+        } catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+    }
+};
+
+/// @brief A stateful allocator that allocates a vector's memory in a file, with shared mappings
+///
+/// Each allocation grows the file by a new region, and maps it, so the vector's elements are
+/// written through to the file by the kernel. The regions of freed blocks are punched out of the
+/// file, so its disk usage follows the live blocks; its apparent size only ever grows.
+///
+/// @tparam T the element type, which must be trivially copyable to be persisted
+///
+/// @note Any number of vectors may be allocated from the same file, but `leak_to_file()` records
+/// a single vector in its header.
+template<typename T>
+class FileAllocator
+{
+  private:
+    std::shared_ptr<MappedFile> m_file;
+
+    template<typename U>
+    friend class FileAllocator;
+
+  public:
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Only trivially copyable types can be persisted in a file");
+
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    explicit FileAllocator(std::shared_ptr<MappedFile> file) noexcept : m_file(std::move(file)) {}
+    template<typename U>
+    FileAllocator(const FileAllocator<U>& other) noexcept : m_file(other.m_file)
+    {
+    }
+
+    [[nodiscard]] const std::shared_ptr<MappedFile>& file() const noexcept { return m_file; }
+
+    /// @brief The length, in bytes, of the region and mapping that back an allocation of `n`
+    /// elements
+    [[nodiscard]] static size_t mapping_length(size_t n) noexcept
+    {
+        const auto page = MappedFile::header_size();
+        return (n * sizeof(T) + page - 1) / page * page;
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        if (n > (std::numeric_limits<std::size_t>::max() / 2) / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(m_file->allocate_region(mapping_length(n == 0 ? 1 : n)));
+    }
+
+    /// @brief Unmap the vector's memory; the file keeps the contents of the persisted vector
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        m_file->deallocate_region(p, mapping_length(n == 0 ? 1 : n));
+    }
+
+    template<class U>
+    bool operator==(const FileAllocator<U>& other) const noexcept
+    {
+        return m_file == other.m_file;
+    }
+
+    template<class U>
+    bool operator!=(const FileAllocator<U>& other) const noexcept
+    {
+        return m_file != other.m_file;
+    }
+};
+
+/// @brief Create an empty std::vector whose memory will be allocated in a new file
+///
+/// @throws std::system_error if the file can't be created
+template<typename T>
+[[nodiscard]] std::vector<T, FileAllocator<T>> make_file_vec(const std::string& path)
+{
+    return std::vector<T, FileAllocator<T>>(FileAllocator<T>(MappedFile::create(path)));
+}
+
+/// @brief Leak a file-backed vector, and persist its length and capacity in the file's header
+///
+/// The vector's memory stays mapped, so the returned parts can be used like any other leaked
+/// vector. Its block and the header are synchronously flushed to the file, so that the vector can
+/// be reconstructed by `parts_from_file()`.
+///
+/// @note After calling this function, the leaky Vec is left in an empty state. If it throws, the
+/// leaky Vec still owns the vector.
+/// @throws std::system_error if the mapping can't be flushed
+template<typename T>
+[[nodiscard]] std::tuple<T*, size_t, size_t, FileAllocator<T>>
+leak_to_file(Vec<T, FileAllocator<T>>& vec)
+{
+    const auto file = vec.as_ref().get_allocator().file();
+    // Persist the block before leaking it, so that the vector still owns it if that fails
+    const auto capacity = vec.claim_usable_capacity();
+    auto* data = vec.as_mut().data();
+    const auto size = vec.as_ref().size();
+    const auto data_offset = data == nullptr ? MappedFile::header_size() : file->offset_of(data);
+    const auto header =
+        FileHeader{FileHeader::expected_magic, data_offset, size, capacity, sizeof(T)};
+
+    if (data != nullptr && msync(data, FileAllocator<T>::mapping_length(capacity), MS_SYNC) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), file->path());
+    }
+    // Write the header only once the data is on disk, so that it never points at stale data
+    const auto written = pwrite(file->fd(), &header, sizeof(header), 0);
+    if (written < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), file->path());
+    }
+    if (written != static_cast<ssize_t>(sizeof(header)))
+    {
+        throw std::system_error(std::make_error_code(std::errc::io_error), file->path());
+    }
+    if (fsync(file->fd()) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), file->path());
+    }
+
+    auto parts = vec.leak();
+    LEAKY_DEBUG_ASSERT(std::get<0>(parts) == data && std::get<2>(parts) == capacity);
+
+    const auto lock = std::lock_guard<std::mutex>(file->m_mutex);
+    file->m_persisted = data == nullptr ? 0 : data_offset;
+    return parts;
+}
+
+/// @brief Map a file written by `leak_to_file()`, and return it as parts for `Vec::from_parts()`
+///
+/// @throws std::system_error if the file can't be opened or mapped, or if it doesn't contain a
+/// vector of `T`
+template<typename T>
+[[nodiscard]] std::tuple<T*, size_t, size_t, FileAllocator<T>>
+parts_from_file(const std::string& path)
+{
+    auto file = MappedFile::open(path);
+
+    FileHeader header{};
+    const auto bytes_read = pread(file->fd(), &header, sizeof(header), 0);
+    if (bytes_read != static_cast<ssize_t>(sizeof(header)) ||
+        header.magic != FileHeader::expected_magic || header.elem_size != sizeof(T) ||
+        header.data_offset < MappedFile::header_size() ||
+        header.data_offset % MappedFile::header_size() != 0 || header.len > header.cap)
+    {
+        throw std::system_error(std::make_error_code(std::errc::invalid_argument), path);
+    }
+
+    const auto cap = static_cast<size_t>(header.cap);
+    if (cap == 0)
+    {
+        return std::make_tuple(
+            static_cast<T*>(nullptr), size_t{0}, size_t{0}, FileAllocator<T>(std::move(file)));
+    }
+
+    if (header.cap > std::numeric_limits<size_t>::max() / 2 / sizeof(T) ||
+        file->m_end < header.data_offset + FileAllocator<T>::mapping_length(cap))
+    {
+        throw std::system_error(std::make_error_code(std::errc::invalid_argument), path);
+    }
+    const auto length = FileAllocator<T>::mapping_length(cap);
+
+    const auto lock = std::lock_guard<std::mutex>(file->m_mutex);
+    auto* data = static_cast<T*>(file->map_region(header.data_offset, length));
+    if (data == nullptr)
+    {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    file->m_persisted = header.data_offset;
+    return std::make_tuple(
+        data, static_cast<size_t>(header.len), cap, FileAllocator<T>(std::move(file)));
+}
+}  // namespace leaky
@@ -0,0 +1,91 @@
+#pragma once
+#include "ffi.h"
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace leaky {
+
+/// @brief A stateful allocator that frees an adopted memory block with its producer's allocator
+///
+/// This allows a std::vector to adopt memory allocated on the other side of a language boundary
+/// without copying it, and without freeing it with the wrong allocator. The allocator remembers the
+/// adopted block, and a callback to free it. Any other memory, e.g., from the vector growing, is
+/// allocated and freed with `std::allocator`.
+///
+/// Use `leaky::Vec<T, ForeignAllocator<T>>::from_foreign()` to adopt a memory block.
+///
+/// @note Copying a vector doesn't copy the adopted block, so copies use `std::allocator` only.
+template<typename T>
+class ForeignAllocator
+{
+  private:
+    leaky_dealloc_fn m_dealloc;
+    void* m_ctx;
+    void* m_foreign_block;
+
+    template<typename U>
+    friend class ForeignAllocator;
+
+  public:
+    using value_type = T;
+    // The adopted block's deallocator goes wherever the block goes
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    /// @brief An allocator that hasn't adopted any foreign memory
+    ForeignAllocator() noexcept : m_dealloc(nullptr), m_ctx(nullptr), m_foreign_block(nullptr) {}
+
+    /// @brief An allocator that frees `foreign_block` by calling `dealloc(ctx, foreign_block, cap)`
+    ForeignAllocator(leaky_dealloc_fn dealloc, void* ctx, void* foreign_block) noexcept :
+        m_dealloc(dealloc), m_ctx(ctx), m_foreign_block(foreign_block)
+    {
+    }
+
+    template<typename U>
+    ForeignAllocator(const ForeignAllocator<U>& other) noexcept :
+        m_dealloc(other.m_dealloc), m_ctx(other.m_ctx), m_foreign_block(other.m_foreign_block)
+    {
+    }
+
+    [[nodiscard]] leaky_dealloc_fn dealloc_fn() const noexcept { return m_dealloc; }
+    [[nodiscard]] void* context() const noexcept { return m_ctx; }
+    [[nodiscard]] void* foreign_block() const noexcept { return m_foreign_block; }
+
+    /// @brief Copies of a vector get their own memory, so they don't need the foreign deallocator
+    [[nodiscard]] ForeignAllocator select_on_container_copy_construction() const noexcept
+    {
+        return ForeignAllocator();
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n) { return std::allocator<T>{}.allocate(n); }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (p != nullptr && p == m_foreign_block)
+        {
+            m_dealloc(m_ctx, p, n);
+            m_foreign_block = nullptr;
+            return;
+        }
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    /// @brief Allocators are equal if they'd free the same foreign block the same way
+    template<class U>
+    bool operator==(const ForeignAllocator<U>& other) const noexcept
+    {
+        return m_dealloc == other.m_dealloc && m_ctx == other.m_ctx &&
+               m_foreign_block == other.m_foreign_block;
+    }
+
+    template<class U>
+    bool operator!=(const ForeignAllocator<U>& other) const noexcept
+    {
+        return !(*this == other);
+    }
+};
+}  // namespace leaky
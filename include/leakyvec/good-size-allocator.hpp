@@ -0,0 +1,157 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#ifdef LEAKY_USE_JEMALLOC
+    #include <jemalloc/jemalloc.h>
+#endif
+
+namespace leaky {
+
+// The two implementations are different types, so that translation units that disagree about
+// LEAKY_USE_JEMALLOC don't violate the one-definition rule
+#ifdef LEAKY_USE_JEMALLOC
+inline namespace jemalloc {
+#else
+inline namespace libc {
+#endif
+
+/// @brief A stateless malloc-compatible allocator that hands out whole size classes, and frees
+/// with the size it knows
+///
+/// Allocators like jemalloc round every request up to a size class, and std::vector never learns
+/// about the slack. This allocator reports the real size of every block through
+/// `usable_capacity()`, so `leaky::Vec::leak()` (or `claim_usable_capacity()`) records it as the
+/// vector's capacity, and every byte that was paid for is usable.
+///
+/// Define `LEAKY_USE_JEMALLOC`, and link jemalloc, to allocate with `mallocx()`, compute the size
+/// classes with `nallocx()`, and free with `sdallocx()`, jemalloc's sized deallocation, which
+/// skips looking up the size class of the freed block. jemalloc guarantees that the whole size
+/// class is usable.
+///
+/// Otherwise, this uses `malloc()` and `free()`, and reports no slack: glibc's
+/// `malloc_usable_size()` may be larger than the request, but writing past the request is
+/// undefined behavior, and `_FORTIFY_SOURCE` flags it.
+///
+/// Either way, the blocks can be freed with `free()`, like `MallocAllocator`'s, when jemalloc is
+/// the process's malloc.
+///
+/// @note The jemalloc and libc allocators are different types, in different inline namespaces, so
+/// define `LEAKY_USE_JEMALLOC` consistently in the translation units that exchange these vectors.
+/// Blocks from one can only be freed by the other when jemalloc is the process's malloc.
+template<typename T>
+struct GoodSizeAllocator
+{
+    using value_type = T;
+
+    GoodSizeAllocator() noexcept = default;
+    template<typename U>
+    constexpr GoodSizeAllocator(const GoodSizeAllocator<U>&) noexcept
+    {
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        if (n == 0)
+        {
+            return nullptr;
+        }
+
+#ifdef LEAKY_USE_JEMALLOC
+        void* p = mallocx(n * sizeof(T), flags);
+#else
+        void* p = nullptr;
+        if constexpr (alignof(T) <= alignof(std::max_align_t))
+        {
+            p = std::malloc(n * sizeof(T));
+        } else
+        {
+            // std::aligned_alloc requires the size to be a multiple of the alignment
+            p = std::aligned_alloc(alignof(T),
+                                   (n * sizeof(T) + alignof(T) - 1) / alignof(T) * alignof(T));
+        }
+#endif
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    /// @brief Free a block of `n` elements, which may be anywhere between the requested capacity
+    /// and its usable capacity
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (p == nullptr)
+        {
+            return;
+        }
+#ifdef LEAKY_USE_JEMALLOC
+        sdallocx(p, n * sizeof(T), flags);
+#else
+        static_cast<void>(n);
+        std::free(p);
+#endif
+    }
+
+    /// @brief The capacity of a block allocated for `n` elements, up to the end of its size class,
+    /// or `n` without jemalloc
+    [[nodiscard]] std::size_t usable_capacity(T* /*p*/, std::size_t n) const noexcept
+    {
+#ifdef LEAKY_USE_JEMALLOC
+        return nallocx(n * sizeof(T), flags) / sizeof(T);
+#else
+        return n;
+#endif
+    }
+
+    /// @brief The number of elements that fit in the size class of a `n`-element request
+    ///
+    /// Reserve this many elements to avoid wasting the slack of the size class. Without jemalloc,
+    /// the size classes can't be computed in advance, so this is `n`.
+    [[nodiscard]] static std::size_t good_size(std::size_t n) noexcept
+    {
+#ifdef LEAKY_USE_JEMALLOC
+        return n == 0 ? 0 : nallocx(n * sizeof(T), flags) / sizeof(T);
+#else
+        return n;
+#endif
+    }
+
+  private:
+#ifdef LEAKY_USE_JEMALLOC
+    static constexpr int lg_alignment() noexcept
+    {
+        int lg = 0;
+        while ((std::size_t{1} << lg) < alignof(T))
+        {
+            lg++;
+        }
+        return lg;
+    }
+
+    // MALLOCX_ALIGN() calls ffs(), so it isn't a constant expression
+    static constexpr int flags =
+        alignof(T) <= alignof(std::max_align_t) ? 0 : MALLOCX_LG_ALIGN(lg_alignment());
+#endif
+};
+
+template<class T, class U>
+constexpr bool operator==(const GoodSizeAllocator<T>&, const GoodSizeAllocator<U>&) noexcept
+{
+    return true;
+}
+
+template<class T, class U>
+constexpr bool operator!=(const GoodSizeAllocator<T>&, const GoodSizeAllocator<U>&) noexcept
+{
+    return false;
+}
+}  // namespace jemalloc or libc
+}  // namespace leaky
@@ -0,0 +1,321 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace leaky {
+
+template<typename T>
+class RegisteredAllocator;
+
+/// @brief A fixed set of equally sized buffers, registered with an io_uring instance
+///
+/// Registering buffers with `IORING_REGISTER_BUFFERS` pins their pages once, so reads and writes
+/// with `IORING_OP_READ_FIXED` and `IORING_OP_WRITE_FIXED` skip pinning and unpinning them on every
+/// request. The buffers are carved out of a single page-aligned mapping, and handed out as the
+/// memory blocks of vectors using `RegisteredAllocator`. A vector's buffer returns to the pool when
+/// the vector is destroyed, so buffers cycle through I/O, `leak()`, and `from_parts()` without
+/// being registered again.
+///
+/// This only uses the raw `io_uring_register` system call, so it works with or without liburing:
+/// pass it `ring.ring_fd`.
+///
+/// Acquiring and releasing buffers is thread-safe, so vectors may be reclaimed on any thread.
+///
+/// @note The pool must outlive every vector allocated from it. This is Linux-only.
+class RegisteredBufferPool
+{
+  private:
+    uint8_t* m_base = nullptr;
+    size_t m_buffer_size;
+    size_t m_buffer_count;
+    std::vector<iovec> m_iovecs;
+    std::mutex m_mutex;
+    std::vector<uint16_t> m_free;
+    int m_ring_fd = -1;
+
+    template<typename T>
+    friend class RegisteredAllocator;
+
+    /// @brief Take a free buffer, or return nullptr if there's none left
+    void* pop() noexcept
+    {
+        const auto lock = std::lock_guard<std::mutex>(m_mutex);
+        if (m_free.empty())
+        {
+            return nullptr;
+        }
+        const auto index = m_free.back();
+        m_free.pop_back();
+        return m_base + index * m_buffer_size;
+    }
+
+    void push(const void* buffer) noexcept
+    {
+        const auto index = buffer_index(buffer);
+        LEAKY_DEBUG_ASSERT(index >= 0);
+        const auto lock = std::lock_guard<std::mutex>(m_mutex);
+        // m_free has room for every buffer, so this never reallocates
+        m_free.push_back(static_cast<uint16_t>(index));
+    }
+
+  public:
+    /// The most buffers the kernel lets a ring register
+    static constexpr size_t max_buffer_count = size_t{1} << 14;
+    /// The largest buffer the kernel lets a ring register
+    static constexpr size_t max_buffer_size = size_t{1} << 30;
+
+    /// @brief Map `buffer_count` buffers of at least `buffer_size` bytes each
+    ///
+    /// The buffer size is rounded up to a whole number of pages. The pages are pre-faulted, since
+    /// registering them faults them in anyway.
+    ///
+    /// @throws std::bad_array_new_length if there are no buffers or more than `max_buffer_count`,
+    /// or if the buffers are empty or larger than `max_buffer_size`
+    /// @throws std::bad_alloc if the buffers can't be mapped
+    RegisteredBufferPool(size_t buffer_count, size_t buffer_size) :
+        m_buffer_size(0), m_buffer_count(buffer_count)
+    {
+        if (buffer_count == 0 || buffer_count > max_buffer_count || buffer_size == 0 ||
+            buffer_size > max_buffer_size)
+        {
+            throw std::bad_array_new_length();
+        }
+        // The page size divides max_buffer_size, so rounding up stays within it
+        const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        m_buffer_size = (buffer_size + page - 1) / page * page;
+        if (m_buffer_size > SIZE_MAX / buffer_count)
+        {
+            throw std::bad_array_new_length();
+        }
+
+        m_iovecs.resize(buffer_count);
+        m_free.reserve(buffer_count);
+        void* base = mmap(nullptr,
+                          m_buffer_size * buffer_count,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE,
+                          -1,
+                          0);
+        if (base == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        m_base = static_cast<uint8_t*>(base);
+
+        // Hand out the lowest indices first
+        for (size_t i = 0; i < buffer_count; i++)
+        {
+            m_iovecs[i] = iovec{m_base + i * m_buffer_size, m_buffer_size};
+            m_free.push_back(static_cast<uint16_t>(buffer_count - 1 - i));
+        }
+    }
+
+    RegisteredBufferPool(const RegisteredBufferPool&) = delete;
+    RegisteredBufferPool& operator=(const RegisteredBufferPool&) = delete;
+
+    ~RegisteredBufferPool() noexcept
+    {
+        unregister_buffers();
+        munmap(m_base, m_buffer_size * m_buffer_count);
+    }
+
+    [[nodiscard]] size_t buffer_size() const noexcept { return m_buffer_size; }
+    [[nodiscard]] size_t buffer_count() const noexcept { return m_buffer_count; }
+
+    /// @brief The number of buffers not used by any vector
+    [[nodiscard]] size_t available() noexcept
+    {
+        const auto lock = std::lock_guard<std::mutex>(m_mutex);
+        return m_free.size();
+    }
+
+    /// @brief The io_uring file descriptor the buffers are registered with, or -1
+    [[nodiscard]] int ring_fd() const noexcept { return m_ring_fd; }
+
+    /// @brief The fixed-buffer index of the buffer containing `p`, or -1 if it's not in the pool
+    [[nodiscard]] int buffer_index(const void* p) const noexcept
+    {
+        const auto* byte = static_cast<const uint8_t*>(p);
+        if (byte < m_base || byte >= m_base + m_buffer_size * m_buffer_count)
+        {
+            return -1;
+        }
+        return static_cast<int>(static_cast<size_t>(byte - m_base) / m_buffer_size);
+    }
+
+    /// @brief Register every buffer with an io_uring instance, so they can be used for fixed I/O
+    ///
+    /// @throws std::system_error if the buffers can't be registered, e.g., because they're
+    /// already registered with this ring, or the process's locked memory limit is too low
+    void register_buffers(int ring_fd)
+    {
+        const auto result = syscall(__NR_io_uring_register,
+                                    ring_fd,
+                                    IORING_REGISTER_BUFFERS,
+                                    m_iovecs.data(),
+                                    static_cast<unsigned>(m_iovecs.size()));
+        if (result < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "io_uring_register");
+        }
+        m_ring_fd = ring_fd;
+    }
+
+    /// @brief Unregister the buffers from their io_uring instance, if they're registered
+    void unregister_buffers() noexcept
+    {
+        if (m_ring_fd >= 0)
+        {
+            static_cast<void>(
+                syscall(__NR_io_uring_register, m_ring_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0));
+            m_ring_fd = -1;
+        }
+    }
+
+    /// @brief Get an empty vector whose memory block is a whole registered buffer
+    ///
+    /// @throws std::bad_alloc if every buffer is in use
+    template<typename T>
+    [[nodiscard]] std::vector<T, RegisteredAllocator<T>> acquire();
+};
+
+/// @brief A stateful allocator that allocates a vector's memory block from a RegisteredBufferPool
+///
+/// Every allocation takes a whole buffer, so a vector can't grow beyond `buffer_size()` bytes, and
+/// `leaky::Vec` reports the whole buffer as the leaked capacity. The allocator part of
+/// `leaky::Vec::leak()` leads back to the pool, so `fixed_buffer_index()` finds the parts' buffer
+/// index for `IORING_OP_READ_FIXED`.
+///
+/// @tparam T the element type, which must be trivially copyable to be read into by the kernel
+template<typename T>
+class RegisteredAllocator
+{
+  private:
+    RegisteredBufferPool* m_pool;
+
+    template<typename U>
+    friend class RegisteredAllocator;
+
+  public:
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Only trivially copyable types can be read into by the kernel");
+
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    explicit RegisteredAllocator(RegisteredBufferPool& pool) noexcept : m_pool(&pool) {}
+    template<typename U>
+    RegisteredAllocator(const RegisteredAllocator<U>& other) noexcept : m_pool(other.m_pool)
+    {
+    }
+
+    [[nodiscard]] RegisteredBufferPool& pool() const noexcept { return *m_pool; }
+
+    /// @brief The most elements a vector using this allocator can hold
+    [[nodiscard]] size_t max_size() const noexcept { return m_pool->buffer_size() / sizeof(T); }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        if (n > max_size())
+        {
+            throw std::bad_array_new_length();
+        }
+        void* p = m_pool->pop();
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t /*n*/) noexcept
+    {
+        if (p != nullptr)
+        {
+            m_pool->push(p);
+        }
+    }
+
+    /// @brief Every block is a whole buffer, whatever the requested capacity
+    [[nodiscard]] std::size_t usable_capacity(T* /*p*/, std::size_t /*n*/) const noexcept
+    {
+        return max_size();
+    }
+
+    template<class U>
+    bool operator==(const RegisteredAllocator<U>& other) const noexcept
+    {
+        return m_pool == other.m_pool;
+    }
+
+    template<class U>
+    bool operator!=(const RegisteredAllocator<U>& other) const noexcept
+    {
+        return m_pool != other.m_pool;
+    }
+};
+
+template<typename T>
+std::vector<T, RegisteredAllocator<T>> RegisteredBufferPool::acquire()
+{
+    auto alloc = RegisteredAllocator<T>(*this);
+    auto vec = std::vector<T, RegisteredAllocator<T>>(alloc);
+    vec.reserve(alloc.max_size());
+    return vec;
+}
+
+/// @brief The fixed-buffer index of a leaked vector's memory block, or -1 if it has none
+template<typename T>
+[[nodiscard]] int
+fixed_buffer_index(const std::tuple<T*, size_t, size_t, RegisteredAllocator<T>>& parts) noexcept
+{
+    const auto& [data, size, capacity, alloc] = parts;
+    static_cast<void>(size);
+    static_cast<void>(capacity);
+    return data == nullptr ? -1 : alloc.pool().buffer_index(data);
+}
+
+/// @brief Prepare an `IORING_OP_READ_FIXED` request that reads into a vector's spare capacity
+///
+/// Once the request completes with `res` bytes, commit them with
+/// `vec.unsafe_set_len(vec.as_ref().size() + res / sizeof(T))`. The caller sets the request's
+/// `user_data` and flags, and keeps the vector's memory block in place until it completes.
+///
+/// @note The buffers must be registered with the ring that the request is submitted to.
+template<typename T>
+void prep_read_fixed(io_uring_sqe& sqe, int fd, Vec<T, RegisteredAllocator<T>>& vec,
+                     uint64_t offset) noexcept
+{
+    auto [spare, spare_len] = vec.spare_capacity();
+    const auto index = vec.as_ref().get_allocator().pool().buffer_index(vec.as_ref().data());
+    LEAKY_DEBUG_ASSERT(index >= 0);
+
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READ_FIXED;
+    sqe.fd = fd;
+    sqe.off = offset;
+    sqe.addr = reinterpret_cast<uintptr_t>(spare);
+    // Buffers are at most max_buffer_size bytes, so this fits
+    sqe.len = static_cast<uint32_t>(spare_len * sizeof(T));
+    sqe.buf_index = static_cast<uint16_t>(index);
+}
+}  // namespace leaky
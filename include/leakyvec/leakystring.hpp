@@ -0,0 +1,301 @@
+#pragma once
+#include "ffi.h"
+#include "leakyvec.hpp"
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+// libc++ and the MSVC STL pack their short and long string representations differently, and the
+// pre-C++11 libstdc++ string is reference counted, so none of them can be leaked.
+#if !defined(LEAKY_STDLIB_LIBSTDCXX) || !_GLIBCXX_USE_CXX11_ABI
+    #error "leaky::String only supports libstdc++ with the C++11 ABI (_GLIBCXX_USE_CXX11_ABI=1)"
+#endif
+
+namespace leaky {
+
+namespace detail {
+    template<typename CharT,
+             typename Traits = std::char_traits<CharT>,
+             typename Alloc = std::allocator<CharT>>
+    struct StringWrapper
+    {
+        using string_type = std::basic_string<CharT, Traits, Alloc>;
+        using pointer = typename string_type::pointer;
+        string_type inner;
+
+        // NOTE: In libstdc++ (with the C++11 ABI), std::basic_string is defined like
+        //
+        //     class basic_string {
+        //         struct _Alloc_hider : allocator_type { pointer _M_p; };
+        //         _Alloc_hider _M_dataplus;
+        //         size_type _M_string_length;
+        //         union {
+        //             CharT _M_local_buf[15 / sizeof(CharT) + 1];
+        //             size_type _M_allocated_capacity;
+        //         };
+        //     };
+        //
+        // Short strings are stored inline in _M_local_buf (the small string optimization), and
+        // _M_p points at it. Otherwise _M_p points at a heap allocation of
+        // _M_allocated_capacity + 1 characters, to leave room for the null terminator.
+        [[nodiscard]] constexpr size_t get_data_ptr_offset() const noexcept
+        {
+            constexpr size_t alloc_size = std::is_empty_v<Alloc> ? 0 : sizeof(Alloc);
+            constexpr size_t alloc_words = (alloc_size + sizeof(pointer) - 1) / sizeof(pointer);
+            static_assert(sizeof(inner) == (alloc_words + 2) * sizeof(pointer) + 16,
+                          "Unexpected std::basic_string memory layout");
+            return alloc_words;
+        }
+
+        [[nodiscard]] pointer* get_data_start_ptr() noexcept
+        {
+            auto* ptr = reinterpret_cast<pointer*>(&inner) + get_data_ptr_offset() + 0;
+            LEAKY_DEBUG_ASSERT(inner.data() == *ptr);
+            return ptr;
+        }
+        [[nodiscard]] size_t* get_size_ptr() noexcept
+        {
+            auto* ptr = reinterpret_cast<size_t*>(&inner) + get_data_ptr_offset() + 1;
+            LEAKY_DEBUG_ASSERT(inner.size() == *ptr);
+            return ptr;
+        }
+        /// @brief Get the inline buffer used by short strings
+        [[nodiscard]] pointer get_local_buf() noexcept
+        {
+            return reinterpret_cast<pointer>(reinterpret_cast<size_t*>(&inner) +
+                                             get_data_ptr_offset() + 2);
+        }
+        /// @brief Get the capacity of a heap-allocated string, not counting the null terminator
+        ///
+        /// @note Only valid if `is_inline()` is false, because it shares storage with the inline
+        /// buffer.
+        [[nodiscard]] size_t* get_capacity_ptr() noexcept
+        {
+            auto* ptr = reinterpret_cast<size_t*>(get_local_buf());
+            LEAKY_DEBUG_ASSERT(is_inline() || inner.capacity() == *ptr);
+            return ptr;
+        }
+
+        /// @brief Whether the string is stored in the inline buffer, rather than on the heap
+        [[nodiscard]] bool is_inline() noexcept { return inner.data() == get_local_buf(); }
+
+        /// @brief Set the data start pointer to a new value
+        ///
+        /// @warning Unless it's the inline buffer, the memory must have been allocated by the
+        /// string's allocator, with room for `capacity() + 1` characters.
+        void unsafe_set_data_start(pointer new_start) noexcept
+        {
+            *get_data_start_ptr() = new_start;
+            LEAKY_DEBUG_ASSERT(inner.data() == new_start);
+        }
+
+        /// @brief Set the size of the string to a new value
+        ///
+        /// @warning This does not write the null terminator!
+        void unsafe_set_size(size_t new_size) noexcept
+        {
+            *get_size_ptr() = new_size;
+            LEAKY_DEBUG_ASSERT(inner.size() == new_size);
+        }
+
+        /// @brief Set the capacity of a heap-allocated string, not counting the null terminator
+        ///
+        /// @warning This overwrites the inline buffer!
+        void unsafe_set_capacity(size_t new_capacity) noexcept
+        {
+            *get_capacity_ptr() = new_capacity;
+            LEAKY_DEBUG_ASSERT(inner.capacity() == new_capacity);
+        }
+
+        static StringWrapper unsafe_from_parts(std::tuple<pointer, size_t, size_t, Alloc> parts)
+        {
+            return unsafe_from_parts(
+                std::get<0>(parts), std::get<1>(parts), std::get<2>(parts), std::get<3>(parts));
+        }
+
+        /// @brief Reconstruct a string from a memory block that fits `capacity` characters
+        ///
+        /// If there's no room after the `size` characters for the null terminator, the characters
+        /// are copied into a new string, and the memory block is deallocated.
+        static StringWrapper
+        unsafe_from_parts(pointer data_start, size_t size, size_t capacity, Alloc alloc = Alloc())
+        {
+            if (data_start == nullptr)
+            {
+                return StringWrapper{string_type(alloc)};
+            }
+            if (size >= capacity)
+            {
+                // Construct rather than assign, so the copy can't be mistaken for one into the
+                // string's own inline buffer
+                StringWrapper wrapper{string_type(data_start, data_start + size, alloc)};
+                alloc.deallocate(data_start, capacity);
+                return wrapper;
+            }
+
+            StringWrapper wrapper{string_type(alloc)};
+            Traits::assign(data_start[size], CharT());
+            wrapper.unsafe_set_data_start(data_start);
+            wrapper.unsafe_set_size(size);
+            wrapper.unsafe_set_capacity(capacity - 1);
+            return wrapper;
+        }
+
+        /// @brief Leak the string's memory block, including its null terminator
+        ///
+        /// The capacity is the number of allocated characters, including the null terminator. If
+        /// the string is stored inline, it's copied into a new allocation first.
+        [[nodiscard]] std::tuple<pointer, size_t, size_t, Alloc> leak_into_parts()
+        {
+            auto alloc = inner.get_allocator();
+            const auto size = inner.size();
+
+            if (is_inline())
+            {
+                if (size == 0)
+                {
+                    return std::make_tuple(pointer{nullptr}, size_t{0}, size_t{0}, alloc);
+                }
+                pointer data = alloc.allocate(size + 1);
+                Traits::copy(data, inner.data(), size + 1);
+                inner.clear();
+                return std::make_tuple(data, size, size + 1, alloc);
+            }
+
+            pointer data = inner.data();
+            const auto capacity = inner.capacity() + 1;
+
+            // Point the string back at its (empty) inline buffer, so it won't free anything
+            Traits::assign(*get_local_buf(), CharT());
+            unsafe_set_data_start(get_local_buf());
+            unsafe_set_size(0);
+
+            return std::make_tuple(data, size, capacity, alloc);
+        }
+    };
+}  // namespace detail
+
+/// @brief a wrapper around std::basic_string that allows leaking its contents and transfering
+/// ownership
+///
+/// The raw parts have the same shape as `leaky::Vec::leak()`, so a leaked string can be used like
+/// a leaked vector of characters. Heap-allocated strings are leaked without copying. Short strings
+/// stored inline in the string object (the small string optimization) are copied into a new
+/// allocation.
+///
+/// @tparam CharT the character type
+/// @tparam Traits the character traits type
+/// @tparam Alloc the allocator type
+///
+/// Example usage:
+///
+/// ```cpp
+/// auto str = std::string(100, 'x');
+/// auto leaky_str = leaky::String<char>(std::move(str));
+/// auto parts = leaky_str.leak();
+///
+/// // ...
+///
+/// auto leaky_str2 = leaky::String<char>::from_parts(parts);
+/// auto str2 = leaky_str2.take();
+/// ```
+template<typename CharT,
+         typename Traits = std::char_traits<CharT>,
+         typename Alloc = std::allocator<CharT>>
+class String
+{
+  private:
+    detail::StringWrapper<CharT, Traits, Alloc> m_inner;
+
+    String(detail::StringWrapper<CharT, Traits, Alloc>&& wrapper) noexcept :
+        m_inner{std::move(wrapper)}
+    {
+    }
+
+  public:
+    using string_type = std::basic_string<CharT, Traits, Alloc>;
+    using pointer = typename string_type::pointer;
+
+    /// @brief Create a leaky String from a std::basic_string. Takes exclusive ownership.
+    String(string_type&& str) noexcept : m_inner{std::move(str)} {}
+    /// @brief Take exclusive ownership from another leaky String.
+    String(String&& other) noexcept : m_inner(std::move(other.m_inner)) {}
+    /// @brief A String owns the internal string exclusively; no copying.
+    String(const String&) = delete;
+    ~String() noexcept = default;
+
+    /// @brief Create a leaky String from its raw parts returned by `leak()`
+    ///
+    /// @note If there's no room after the characters for a null terminator, for example if the
+    /// parts came from a vector of characters, the characters are copied into a new string.
+    static String from_parts(std::tuple<pointer, size_t, size_t, Alloc> parts)
+    {
+        LEAKY_LEDGER_RECLAIM(CharT, std::get<0>(parts), std::get<2>(parts));
+        return String(detail::StringWrapper<CharT, Traits, Alloc>::unsafe_from_parts(parts));
+    }
+
+    /// @brief Create a leaky String from the C ABI raw parts returned by `leak_to_c()`
+    ///
+    /// @note The element size of the parts must match `CharT`, and their alignment must be a power
+    /// of two, at least `alignof(CharT)`.
+    static String from_c(const leaky_raw_parts& parts, Alloc alloc = Alloc())
+    {
+        LEAKY_DEBUG_ASSERT(parts.elem_size == sizeof(CharT));
+        LEAKY_DEBUG_ASSERT((detail::is_adoptable_alignment<CharT, Alloc>(parts.align)));
+        LEAKY_LEDGER_RECLAIM(CharT, parts.ptr, parts.cap);
+        return String(detail::StringWrapper<CharT, Traits, Alloc>::unsafe_from_parts(
+            static_cast<pointer>(parts.ptr), parts.len, parts.cap, std::move(alloc)));
+    }
+
+    String& operator=(const String&) = delete;
+    String& operator=(String&& other) noexcept
+    {
+        m_inner = std::move(other.m_inner);
+        return *this;
+    }
+
+    /// @brief Take ownership of the std::basic_string back
+    ///
+    /// @note After calling this method, the internal std::basic_string is left in an empty state.
+    string_type take() noexcept { return std::move(m_inner.inner); }
+    /// @brief Get a const reference to the internal std::basic_string
+    const string_type& as_ref() const noexcept { return m_inner.inner; }
+    /// @brief Get a mutable reference to the internal std::basic_string
+    string_type& as_mut() noexcept { return m_inner.inner; }
+
+    /// @brief Leak the internal string as its raw parts
+    ///
+    /// The tuple contains, in order:
+    /// 1. pointer to the start of the string's data block, which is null terminated
+    /// 2. size of the string (number of characters, not counting the null terminator)
+    /// 3. capacity of the string (number of allocated characters, counting the null terminator)
+    /// 4. the allocator that owns the string's memory block
+    ///
+    /// An empty string leaks as a null pointer with zero size and capacity.
+    ///
+    /// @note After calling this method, the internal std::basic_string is left in an empty state.
+    /// @throws std::bad_alloc if a short string needs to be copied onto the heap, and that fails
+    [[nodiscard]] std::tuple<pointer, size_t, size_t, Alloc> leak()
+    {
+        auto parts = m_inner.leak_into_parts();
+        LEAKY_LEDGER_LEAK(CharT, std::get<0>(parts), std::get<2>(parts));
+        return parts;
+    }
+
+    /// @brief Leak the internal string as its raw parts, with a C ABI
+    ///
+    /// @see Vec::leak_to_c()
+    [[nodiscard]] leaky_raw_parts leak_to_c()
+    {
+        static_assert(std::allocator_traits<Alloc>::is_always_equal::value,
+                      "Only strings with stateless allocators can be leaked through the C ABI");
+        auto [data, size, capacity, alloc] = m_inner.leak_into_parts();
+        static_cast<void>(alloc);
+        LEAKY_LEDGER_LEAK(CharT, data, capacity);
+        return leaky_raw_parts{
+            static_cast<void*>(data), size, capacity, sizeof(CharT), alignof(CharT)};
+    }
+};  // class String
+}  // namespace leaky
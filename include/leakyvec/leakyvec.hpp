@@ -1,4 +1,9 @@
 #pragma once
+#include "ffi.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <tuple>
 #include <type_traits>
 #include <vector>
@@ -14,9 +19,97 @@
     #define LEAKY_DEBUG_ASSERT(x) assert(x)
 #endif
 
+// Opt in to counting leaked buffers per element type (see leakyvec/ledger.hpp). When disabled,
+// the hooks compile to nothing.
+#ifdef LEAKY_ENABLE_LEDGER
+    #include "ledger.hpp"
+    #define LEAKY_LEDGER_LEAK(T, ptr, capacity)                                                    \
+        ::leaky::ledger::on_leak<T>(static_cast<const void*>(ptr), capacity)
+    #define LEAKY_LEDGER_RECLAIM(T, ptr, capacity)                                                 \
+        ::leaky::ledger::on_reclaim<T>(static_cast<const void*>(ptr), capacity)
+#else
+    #define LEAKY_LEDGER_LEAK(T, ptr, capacity)                                                    \
+        do                                                                                         \
+        {                                                                                          \
+        } while (0)
+    #define LEAKY_LEDGER_RECLAIM(T, ptr, capacity)                                                 \
+        do                                                                                         \
+        {                                                                                          \
+        } while (0)
+#endif
+
+// Detect which standard library's std::vector layout we're poking at. These are defined by any
+// standard library header, so <vector> above is enough.
+#if defined(_LIBCPP_VERSION)
+    #define LEAKY_STDLIB_LIBCXX
+    #define LEAKY_STDLIB_VERSION _LIBCPP_VERSION
+#elif defined(__GLIBCXX__)
+    #define LEAKY_STDLIB_LIBSTDCXX
+    #define LEAKY_STDLIB_VERSION __GLIBCXX__
+#elif defined(_MSVC_STL_VERSION)
+    #define LEAKY_STDLIB_MSVC
+    #define LEAKY_STDLIB_VERSION _MSVC_STL_VERSION
+#else
+    #error "Unsupported standard library: the memory layout of std::vector is unknown"
+#endif
+
+// CMake probes the std::vector layout at configure time, unless it's disabled with
+// -DLEAKY_PROBE_LAYOUT=OFF. The config only defines LEAKY_LAYOUT_PROBED for the standard library
+// and version it was probed with. The probed offsets are known to be right, so checking them at
+// runtime in debug builds is redundant.
+#if __has_include(<leakyvec/config.hpp>)
+    #include <leakyvec/config.hpp>
+#endif
+#ifdef LEAKY_LAYOUT_PROBED
+    #define LEAKY_LAYOUT_ASSERT(x)                                                                 \
+        do                                                                                         \
+        {                                                                                          \
+        } while (0)
+#else
+    #define LEAKY_LAYOUT_ASSERT(x) LEAKY_DEBUG_ASSERT(x)
+#endif
+
 namespace leaky {
 
 namespace detail {
+    /// @brief Whether an allocator reports the real capacity of the blocks it allocated, with
+    /// `usable_capacity(p, n)`
+    template<typename Alloc, typename = void>
+    struct has_usable_capacity : std::false_type
+    {
+    };
+
+    template<typename Alloc>
+    struct has_usable_capacity<Alloc,
+                               std::void_t<decltype(std::declval<const Alloc&>().usable_capacity(
+                                   std::declval<typename std::allocator_traits<Alloc>::pointer>(),
+                                   size_t{}))>> : std::true_type
+    {
+    };
+
+    /// @brief The alignment of the blocks an allocator allocates: `alignof(T)`, unless the
+    /// allocator declares a larger `alignment`
+    template<typename T, typename Alloc, typename = void>
+    struct alloc_alignment : std::integral_constant<size_t, alignof(T)>
+    {
+    };
+
+    template<typename T, typename Alloc>
+    struct alloc_alignment<T, Alloc, std::void_t<decltype(Alloc::alignment)>>
+        : std::integral_constant<size_t,
+                                 (Alloc::alignment > alignof(T) ? Alloc::alignment : alignof(T))>
+    {
+    };
+
+    /// @brief Whether a vector of `T` with allocator `Alloc` can adopt a block aligned to `align`,
+    /// e.g., a 64-byte aligned Arrow buffer for a vector of `int32_t`
+    template<typename T, typename Alloc>
+    constexpr bool is_adoptable_alignment(size_t align) noexcept
+    {
+        return align != 0 && (align & (align - 1)) == 0 &&
+               align >= alloc_alignment<T, Alloc>::value;
+    }
+
     template<typename T, typename Alloc = typename std::vector<T>::allocator_type>
     struct VecWrapper
     {
@@ -38,25 +131,72 @@ namespace detail {
         //         pointer _M_end_of_storage;
         //     };
         //
-        // TODO: Look at MSVC and libc++ implementations as well!
-        template<typename A = Alloc, typename D = std::allocator<T>>
-        [[nodiscard]] constexpr std::enable_if_t<std::is_same_v<A, D>, size_t>
-        get_data_ptr_offset() const noexcept
+        // In libc++, the allocator comes last, compressed into the end-of-storage pointer:
+        //
+        //     class vector {
+        //         pointer __begin_;
+        //         pointer __end_;
+        //         __compressed_pair<pointer, allocator_type> __end_cap_;
+        //     };
+        //
+        // In the MSVC STL, the allocator comes first, and the pointers are prefixed by a container
+        // proxy pointer when iterator debugging is enabled:
+        //
+        //     class vector {
+        //         _Compressed_pair<_Alty, _Vector_val> _Mypair;
+        //     };
+        //     struct _Compressed_pair : _Alty { _Vector_val _Myval2; }; // zero-sized allocator
+        //     struct _Compressed_pair { _Alty _Myval1; _Vector_val _Myval2; }; // otherwise
+        //     struct _Vector_val : _Container_base {
+        //         pointer _Myfirst;
+        //         pointer _Mylast;
+        //         pointer _Myend;
+        //     };
+        //     struct _Container_base12 { _Container_proxy* _Myproxy; }; // if _ITERATOR_DEBUG_LEVEL
+        //     struct _Container_base0 {};                               // otherwise
+        //
+        // In all three, the start, finish, and end-of-storage pointers are adjacent and in order.
+        [[nodiscard]] constexpr size_t get_data_ptr_offset() const noexcept
         {
-            // The default allocator is not stored in the std::vector
-            static_assert(sizeof(inner) == 3 * sizeof(pointer));
-            return 0;
+            // Stateless allocators are zero-sized thanks to the empty base optimization. Stateful
+            // allocators are padded out to the alignment of the pointers that follow them.
+            constexpr size_t alloc_size = std::is_empty_v<Alloc> ? 0 : sizeof(Alloc);
+            constexpr size_t alloc_words = (alloc_size + sizeof(pointer) - 1) / sizeof(pointer);
+#if defined(LEAKY_LAYOUT_PROBED)
+            static_assert(LEAKY_PROBED_STDLIB_VERSION == LEAKY_STDLIB_VERSION,
+                          "The standard library differs from the one probed at configure time");
+            static_assert(sizeof(std::vector<int>) == config::vector_words * sizeof(void*),
+                          "std::vector's layout differs from the one probed at configure time");
+            constexpr size_t extra_words = config::vector_words - 3;
+            constexpr size_t shift = config::vector_allocator_first ? alloc_words : 0;
+            constexpr size_t offset = config::vector_pointer_offsets[0] + shift;
+#elif defined(LEAKY_STDLIB_LIBSTDCXX)
+            constexpr size_t extra_words = 0;
+            constexpr size_t offset = alloc_words;
+#elif defined(LEAKY_STDLIB_LIBCXX)
+            constexpr size_t extra_words = 0;
+            constexpr size_t offset = 0;
+#elif defined(LEAKY_STDLIB_MSVC)
+            constexpr size_t extra_words = _ITERATOR_DEBUG_LEVEL != 0 ? 1 : 0;
+            constexpr size_t offset = alloc_words + extra_words;
+#endif
+            static_assert(sizeof(inner) == (alloc_words + extra_words + 3) * sizeof(pointer),
+                          "Unexpected std::vector memory layout");
+            // Return the offset in words, not in bytes, because when we do pointer arithmetic, it
+            // increments by sizeof(pointer), not in bytes.
+            return offset;
         }
 
-        template<typename A = Alloc, typename D = std::allocator<T>>
-        [[nodiscard]] constexpr std::enable_if_t<!std::is_same_v<A, D>, size_t>
-        get_data_ptr_offset() const noexcept
+        /// @brief The offset of the start (0), finish (1), or end-of-storage (2) pointer, in words
+        [[nodiscard]] constexpr size_t get_pointer_offset(size_t index) const noexcept
         {
-            // Any non-default allocators are stored at the beginning of the std::vector
-            static_assert(sizeof(inner) == sizeof(Alloc) + 3 * sizeof(pointer));
-            // Return the offset in words, not in bytes, because when we do pointer arithmetic, it
-            // increments by sizeof(pointer), not in bytes.
-            return sizeof(Alloc) / sizeof(pointer);
+#if defined(LEAKY_LAYOUT_PROBED)
+            return get_data_ptr_offset() + config::vector_pointer_offsets[index] -
+                   config::vector_pointer_offsets[0];
+#else
+            // The pointers are adjacent and in order in all the built-in layouts
+            return get_data_ptr_offset() + index;
+#endif
         }
 
         [[nodiscard]] pointer get_data_start() noexcept { return inner.data(); }
@@ -64,8 +204,8 @@ namespace detail {
         {
             // The offset is implementation defined, and depends on whether the std::vector uses the
             // default allocator.
-            auto* ptr = reinterpret_cast<pointer*>(&inner) + get_data_ptr_offset() + 0;
-            LEAKY_DEBUG_ASSERT(get_data_start() == *ptr);
+            auto* ptr = reinterpret_cast<pointer*>(&inner) + get_pointer_offset(0);
+            LEAKY_LAYOUT_ASSERT(get_data_start() == *ptr);
             return ptr;
         };
 
@@ -77,7 +217,7 @@ namespace detail {
             // inner._M_impl._M_start = new_start;
             auto* data_start_ptr = get_data_start_ptr();
             *data_start_ptr = new_start;
-            LEAKY_DEBUG_ASSERT(inner.data() == new_start);
+            LEAKY_LAYOUT_ASSERT(inner.data() == new_start);
         }
 
         [[nodiscard]] pointer get_data_end() noexcept
@@ -87,8 +227,8 @@ namespace detail {
         }
         [[nodiscard]] pointer* get_data_end_ptr() noexcept
         {
-            auto* ptr = reinterpret_cast<pointer*>(&inner) + get_data_ptr_offset() + 1;
-            LEAKY_DEBUG_ASSERT(get_data_end() == *ptr);
+            auto* ptr = reinterpret_cast<pointer*>(&inner) + get_pointer_offset(1);
+            LEAKY_LAYOUT_ASSERT(get_data_end() == *ptr);
             return ptr;
         }
 
@@ -101,7 +241,7 @@ namespace detail {
             // inner._M_impl._M_finish = inner._M_impl._M_start + new_size;
             auto* data_end_ptr = get_data_end_ptr();
             *data_end_ptr = get_data_start() + new_size;
-            LEAKY_DEBUG_ASSERT(inner.size() == new_size);
+            LEAKY_LAYOUT_ASSERT(inner.size() == new_size);
         }
 
         [[nodiscard]] pointer get_capacity_end() noexcept
@@ -111,8 +251,8 @@ namespace detail {
         }
         [[nodiscard]] pointer* get_capacity_end_ptr() noexcept
         {
-            auto* ptr = reinterpret_cast<pointer*>(&inner) + get_data_ptr_offset() + 2;
-            LEAKY_DEBUG_ASSERT(get_capacity_end() == *ptr);
+            auto* ptr = reinterpret_cast<pointer*>(&inner) + get_pointer_offset(2);
+            LEAKY_LAYOUT_ASSERT(get_capacity_end() == *ptr);
             return ptr;
         }
 
@@ -125,20 +265,92 @@ namespace detail {
             // inner._M_impl._M_end_of_storage = inner._M_impl._M_start + new_capacity;
             auto* capacity_end_ptr = get_capacity_end_ptr();
             *capacity_end_ptr = get_data_start() + new_capacity;
-            LEAKY_DEBUG_ASSERT(inner.capacity() == new_capacity);
+            LEAKY_LAYOUT_ASSERT(inner.capacity() == new_capacity);
+        }
+
+        /// @brief Get a pointer to the allocator stored inside the std::vector
+        ///
+        /// @note Stateless allocators aren't stored in the std::vector, so this is only available
+        /// for stateful allocators.
+        [[nodiscard]] Alloc* get_allocator_ptr() noexcept
+        {
+            static_assert(!std::is_empty_v<Alloc>, "Stateless allocators aren't stored");
+            // Stateful allocators are stored at the beginning of the std::vector, except for
+            // libc++, which stores them after the pointers. See get_data_ptr_offset().
+#if defined(LEAKY_LAYOUT_PROBED)
+            constexpr bool after_pointers = !config::vector_allocator_first;
+#elif defined(LEAKY_STDLIB_LIBCXX)
+            constexpr bool after_pointers = true;
+#else
+            constexpr bool after_pointers = false;
+#endif
+            constexpr size_t offset =
+                after_pointers
+                    ? (3 * sizeof(pointer) + alignof(Alloc) - 1) / alignof(Alloc) * alignof(Alloc)
+                    : 0;
+            return reinterpret_cast<Alloc*>(reinterpret_cast<unsigned char*>(&inner) + offset);
+        }
+
+        /// @brief Move the allocator out of the vector, rather than copying it
+        ///
+        /// @warning This leaves the vector's allocator in a moved-from state, so the vector must
+        /// not allocate or deallocate anything until `unsafe_set_allocator()` puts one back.
+        [[nodiscard]] Alloc unsafe_take_allocator() noexcept
+        {
+            if constexpr (std::is_empty_v<Alloc>)
+            {
+                return inner.get_allocator();
+            } else
+            {
+                return std::move(*get_allocator_ptr());
+            }
+        }
+
+        /// @brief Move an allocator into the vector, rather than copying it
+        ///
+        /// @warning The vector's memory block must be deallocatable by the new allocator!
+        void unsafe_set_allocator(Alloc&& alloc) noexcept
+        {
+            if constexpr (!std::is_empty_v<Alloc>)
+            {
+                *get_allocator_ptr() = std::move(alloc);
+            }
         }
 
         static VecWrapper<T, Alloc>
-        unsafe_from_parts(std::tuple<pointer, size_t, size_t, Alloc> parts) noexcept
+        unsafe_from_parts(const std::tuple<pointer, size_t, size_t, Alloc>& parts) noexcept
         {
             return unsafe_from_parts(
                 std::get<0>(parts), std::get<1>(parts), std::get<2>(parts), std::get<3>(parts));
         }
 
+        /// @brief Reconstruct a vector from its raw parts, moving the allocator into it
+        ///
+        /// std::vector has no constructor that moves an allocator in, so it's constructed with a
+        /// copy of the moved-from husk of the allocator instead, which is cheap for handle-like
+        /// allocators, and then the real allocator is moved into place.
+        static VecWrapper<T, Alloc>
+        unsafe_from_parts(std::tuple<pointer, size_t, size_t, Alloc>&& parts) noexcept
+        {
+            if constexpr (std::is_empty_v<Alloc> || !std::is_move_assignable_v<Alloc>)
+            {
+                return unsafe_from_parts(static_cast<const decltype(parts)&>(parts));
+            } else
+            {
+                Alloc alloc = std::move(std::get<3>(parts));
+                VecWrapper<T, Alloc> wrapper{std::vector<T, Alloc>(std::get<3>(parts))};
+                wrapper.unsafe_set_allocator(std::move(alloc));
+                wrapper.unsafe_set_data_start(std::get<0>(parts));
+                wrapper.unsafe_set_size(std::get<1>(parts));
+                wrapper.unsafe_set_capacity(std::get<2>(parts));
+                return wrapper;
+            }
+        }
+
         static VecWrapper<T, Alloc> unsafe_from_parts(pointer data_start,
                                                       size_t size,
                                                       size_t capacity,
-                                                      Alloc alloc = Alloc()) noexcept
+                                                      const Alloc& alloc = Alloc()) noexcept
         {
             VecWrapper<T, Alloc> wrapper{std::vector<T, Alloc>(alloc)};
             wrapper.unsafe_set_data_start(data_start);
@@ -147,12 +359,30 @@ namespace detail {
             return wrapper;
         }
 
-        [[nodiscard]] std::tuple<pointer, size_t, size_t, Alloc> leak_into_parts() noexcept
+        /// @brief Grow the capacity to all of the memory block, if the allocator knows it's larger
+        /// than requested
+        void extend_to_usable_capacity() noexcept
         {
+            if constexpr (has_usable_capacity<Alloc>::value)
+            {
+                if (inner.data() != nullptr)
+                {
+                    const auto capacity =
+                        inner.get_allocator().usable_capacity(inner.data(), inner.capacity());
+                    LEAKY_DEBUG_ASSERT(capacity >= inner.capacity());
+                    unsafe_set_capacity(capacity);
+                }
+            }
+        }
+
+        /// @brief Leak the vector's memory block, along with a copy of its allocator
+        [[nodiscard]] std::tuple<pointer, size_t, size_t, Alloc> leak_into_parts() & noexcept
+        {
+            extend_to_usable_capacity();
             pointer data_start = inner.data();
             const auto size = inner.size();
             const auto capacity = inner.capacity();
-            const auto retval = std::make_tuple(data_start, size, capacity, inner.get_allocator());
+            auto retval = std::make_tuple(data_start, size, capacity, inner.get_allocator());
 
             unsafe_set_data_start(nullptr);
             unsafe_set_size(0);
@@ -160,6 +390,38 @@ namespace detail {
 
             return retval;
         }
+
+        /// @brief Leak the vector's memory block, moving its allocator out of it
+        ///
+        /// @note The vector is left with a moved-from allocator, so it must only be destroyed.
+        [[nodiscard]] std::tuple<pointer, size_t, size_t, Alloc> leak_into_parts() && noexcept
+        {
+            extend_to_usable_capacity();
+            pointer data_start = inner.data();
+            const auto size = inner.size();
+            const auto capacity = inner.capacity();
+
+            unsafe_set_data_start(nullptr);
+            unsafe_set_size(0);
+            unsafe_set_capacity(0);
+
+            return std::make_tuple(data_start, size, capacity, unsafe_take_allocator());
+        }
+    };
+
+    /// @brief Whether an allocator can grow an allocation in place with `reallocate(p, old, new)`
+    template<typename Alloc, typename = void>
+    struct has_reallocate : std::false_type
+    {
+    };
+
+    template<typename Alloc>
+    struct has_reallocate<Alloc,
+                          std::void_t<decltype(std::declval<Alloc&>().reallocate(
+                              std::declval<typename std::allocator_traits<Alloc>::pointer>(),
+                              std::declval<size_t>(),
+                              std::declval<size_t>()))>> : std::true_type
+    {
     };
 }  // namespace detail
 
@@ -190,10 +452,18 @@ class Vec
     // Hide the yucky pointer math and helper methods, but still enable unit testing them
     detail::VecWrapper<T, Alloc> m_inner;
 
+    // cast_into() constructs Vecs of other element types from their wrappers
+    template<typename, typename>
+    friend class Vec;
+
     Vec(detail::VecWrapper<T, Alloc>&& wrapper) noexcept : m_inner{std::move(wrapper)} {}
 
   public:
     using pointer = typename std::vector<T, Alloc>::pointer;
+    using allocator_type = Alloc;
+    /// @brief A leaky Vec of `U`, with the allocator rebound to `U`
+    template<typename U>
+    using rebind_vec = Vec<U, typename std::allocator_traits<Alloc>::template rebind_alloc<U>>;
 
     /// @brief Create a leaky Vec from a std::vector. Takes exclusive ownership.
     Vec(std::vector<T, Alloc>&& vec) noexcept : m_inner{std::move(vec)} {}
@@ -204,11 +474,60 @@ class Vec
     ~Vec() noexcept = default;
 
     /// @brief Create a leaky Vec from its raw parts returned by `leak()`
-    static Vec from_parts(std::tuple<pointer, size_t, size_t, Alloc> parts) noexcept
+    static Vec from_parts(const std::tuple<pointer, size_t, size_t, Alloc>& parts) noexcept
     {
+        LEAKY_LEDGER_RECLAIM(T, std::get<0>(parts), std::get<2>(parts));
         return Vec(std::move(detail::VecWrapper<T, Alloc>::unsafe_from_parts(parts)));
     }
 
+    /// @brief Create a leaky Vec from its raw parts returned by `leak()`, moving the allocator
+    /// into it rather than copying it
+    static Vec from_parts(std::tuple<pointer, size_t, size_t, Alloc>&& parts) noexcept
+    {
+        LEAKY_LEDGER_RECLAIM(T, std::get<0>(parts), std::get<2>(parts));
+        return Vec(detail::VecWrapper<T, Alloc>::unsafe_from_parts(std::move(parts)));
+    }
+
+    /// @brief Create a leaky Vec from the C ABI raw parts returned by `leak_to_c()`
+    ///
+    /// @note The element size of the parts must match `T`, and their alignment must be a power of
+    /// two, at least that of the allocator's blocks.
+    static Vec from_c(const leaky_raw_parts& parts, Alloc alloc = Alloc()) noexcept
+    {
+        LEAKY_DEBUG_ASSERT(parts.elem_size == sizeof(T));
+        LEAKY_DEBUG_ASSERT((detail::is_adoptable_alignment<T, Alloc>(parts.align)));
+        LEAKY_LEDGER_RECLAIM(T, parts.ptr, parts.cap);
+        return Vec(std::move(detail::VecWrapper<T, Alloc>::unsafe_from_parts(
+            static_cast<pointer>(parts.ptr), parts.len, parts.cap, std::move(alloc))));
+    }
+
+    /// @brief Adopt a memory block allocated by a foreign allocator
+    ///
+    /// The vector frees the memory block by calling `dealloc(ctx, data, capacity)`. The allocator
+    /// type must be `leaky::ForeignAllocator<T>` (see `leakyvec/foreign-allocator.hpp`).
+    static Vec from_foreign(pointer data,
+                            size_t size,
+                            size_t capacity,
+                            leaky_dealloc_fn dealloc,
+                            void* ctx) noexcept
+    {
+        return Vec(std::move(detail::VecWrapper<T, Alloc>::unsafe_from_parts(
+            data, size, capacity, Alloc(dealloc, ctx, static_cast<void*>(data)))));
+    }
+
+    /// @brief Adopt a memory block allocated by a foreign allocator, from its C ABI raw parts
+    ///
+    /// @see from_foreign()
+    /// @note The element size of the parts must match `T`, and their alignment must be a power of
+    /// two, at least `alignof(T)`. Over-aligned blocks, like Arrow's and NumPy's, are fine.
+    static Vec
+    from_foreign(const leaky_raw_parts& parts, leaky_dealloc_fn dealloc, void* ctx) noexcept
+    {
+        LEAKY_DEBUG_ASSERT(parts.elem_size == sizeof(T));
+        LEAKY_DEBUG_ASSERT((detail::is_adoptable_alignment<T, Alloc>(parts.align)));
+        return from_foreign(static_cast<pointer>(parts.ptr), parts.len, parts.cap, dealloc, ctx);
+    }
+
     Vec& operator=(const Vec&) = delete;
     Vec& operator=(Vec&& other) noexcept
     {
@@ -226,7 +545,7 @@ class Vec
     std::vector<T, Alloc>& as_mut() noexcept { return m_inner.inner; }
 
     /// @brief Get the allocator that owns the vector's memory
-    [[nodiscard]] constexpr Alloc get_allocator() const noexcept { return m_inner.get_allocator(); }
+    [[nodiscard]] Alloc get_allocator() const noexcept { return m_inner.inner.get_allocator(); }
 
     /// @brief Leak the internal vector as its raw parts
     ///
@@ -237,9 +556,178 @@ class Vec
     /// 4. the allocator that owns the vector's memory block
     ///
     /// @note After calling this method, the internal std::vector is left in an empty state.
-    [[nodiscard]] std::tuple<pointer, size_t, size_t, Alloc> leak() noexcept
+    [[nodiscard]] std::tuple<pointer, size_t, size_t, Alloc> leak() & noexcept
+    {
+        auto parts = m_inner.leak_into_parts();
+        LEAKY_LEDGER_LEAK(T, std::get<0>(parts), std::get<2>(parts));
+        return parts;
+    }
+
+    /// @brief Leak the internal vector as its raw parts, moving the allocator out rather than
+    /// copying it
+    ///
+    /// This is chosen for expiring leaky Vecs, e.g., `std::move(leaky_vec).leak()`, or
+    /// `leaky::Vec<T>(std::move(vec)).leak()`.
+    ///
+    /// @note After calling this method, the leaky Vec must only be destroyed.
+    [[nodiscard]] std::tuple<pointer, size_t, size_t, Alloc> leak() && noexcept
+    {
+        auto parts = std::move(m_inner).leak_into_parts();
+        LEAKY_LEDGER_LEAK(T, std::get<0>(parts), std::get<2>(parts));
+        return parts;
+    }
+
+    /// @brief Leak the internal vector as its raw parts, with a C ABI
+    ///
+    /// Because `leaky_raw_parts` can't carry an allocator, this is only available for stateless
+    /// allocators, where any instance can free memory allocated by any other.
+    ///
+    /// @note After calling this method, the internal std::vector is left in an empty state.
+    [[nodiscard]] leaky_raw_parts leak_to_c() noexcept
     {
-        return m_inner.leak_into_parts();
+        static_assert(std::allocator_traits<Alloc>::is_always_equal::value,
+                      "Only vectors with stateless allocators can be leaked through the C ABI");
+        auto [data, size, capacity, alloc] = m_inner.leak_into_parts();
+        static_cast<void>(alloc);
+        LEAKY_LEDGER_LEAK(T, data, capacity);
+        return leaky_raw_parts{static_cast<void*>(data),
+                               size,
+                               capacity,
+                               sizeof(T),
+                               detail::alloc_alignment<T, Alloc>::value};
+    }
+
+    /// @brief Get the uninitialized tail of the vector's allocated memory block
+    ///
+    /// The tuple contains, in order:
+    /// 1. pointer to one past the last initialized element
+    /// 2. number of allocated, but uninitialized, elements after it
+    ///
+    /// This is intended to be filled in directly by an I/O call like `recv` or `memcpy`, and then
+    /// committed with `unsafe_set_len()`.
+    [[nodiscard]] std::tuple<pointer, size_t> spare_capacity() noexcept
+    {
+        return std::make_tuple(m_inner.get_data_end(),
+                               m_inner.inner.capacity() - m_inner.inner.size());
+    }
+
+    /// @brief Grow the capacity to the whole memory block, when the allocator reports that it's
+    /// larger than requested through `usable_capacity(p, n)`
+    ///
+    /// `leak()` does this implicitly. Doing it earlier exposes the slack through
+    /// `spare_capacity()`, e.g., to fill a block up to its allocator's size class.
+    ///
+    /// @return the new capacity
+    size_t claim_usable_capacity() noexcept
+    {
+        m_inner.extend_to_usable_capacity();
+        return m_inner.inner.capacity();
+    }
+
+    /// @brief Set the length of the vector without initializing or destroying any elements
+    ///
+    /// @warning The first `new_len` elements must have been initialized, e.g., by writing to the
+    /// `spare_capacity()` block!
+    /// @note `new_len` must not exceed `capacity()`.
+    void unsafe_set_len(size_t new_len) noexcept
+    {
+        static_assert(std::is_trivially_default_constructible_v<T>,
+                      "Uninitialized elements are only allowed for trivially constructible types");
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "Uninitialized elements are only allowed for trivially destructible types");
+        LEAKY_DEBUG_ASSERT(new_len <= m_inner.inner.capacity());
+        m_inner.unsafe_set_size(new_len);
+    }
+
+    /// @brief Resize the vector without initializing any new elements
+    ///
+    /// Unlike `std::vector::resize`, this does not zero-fill the new elements. If `new_len` exceeds
+    /// the current capacity, the vector is reallocated first, which preserves the existing
+    /// elements.
+    ///
+    /// @warning The new elements are uninitialized, and must be written before being read!
+    void resize_uninit(size_t new_len)
+    {
+        if (new_len > m_inner.inner.capacity())
+        {
+            m_inner.inner.reserve(new_len);
+        }
+        unsafe_set_len(new_len);
+    }
+
+    /// @brief Reserve capacity by growing the vector's memory block with the allocator's
+    /// `reallocate()`, rather than allocating a new block and copying every element into it
+    ///
+    /// `reallocate(p, old_capacity, new_capacity)` is provided by `leaky::MallocAllocator` through
+    /// `realloc()`, and by `leaky::MmapAllocator` through `mremap()`, which can let the kernel
+    /// remap pages instead of copying them. The memory block may still move.
+    ///
+    /// @note Only available for trivially copyable types, since the elements are relocated with
+    /// their bytes.
+    void reserve_in_place(size_t new_capacity)
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "Elements can only be relocated in place if they are trivially copyable");
+        static_assert(detail::has_reallocate<Alloc>::value,
+                      "The allocator must provide reallocate(p, old_capacity, new_capacity)");
+
+        const auto capacity = m_inner.inner.capacity();
+        if (new_capacity <= capacity)
+        {
+            return;
+        }
+
+        const auto size = m_inner.inner.size();
+        auto alloc = m_inner.inner.get_allocator();
+        pointer data = m_inner.get_data_start();
+        data = data == nullptr ? alloc.allocate(new_capacity)
+                               : alloc.reallocate(data, capacity, new_capacity);
+
+        m_inner.unsafe_set_data_start(data);
+        m_inner.unsafe_set_size(size);
+        m_inner.unsafe_set_capacity(new_capacity);
+    }
+
+    /// @brief Reinterpret the vector's memory block as a vector of `U`, without copying it
+    ///
+    /// The allocator is rebound with `std::allocator_traits<Alloc>::rebind_alloc<U>`. This fails
+    /// and leaves the vector unchanged unless the data block is aligned for `U`, and its size and
+    /// capacity in bytes are both multiples of `sizeof(U)`.
+    ///
+    /// @warning The rebound allocator must be able to deallocate the block as an allocation of `U`,
+    /// which holds for `MallocAllocator`, `AlignedAllocator`, and `std::allocator` as long as
+    /// neither type is over-aligned or both have the same alignment. The bytes must also be valid
+    /// values of `U`.
+    /// @note After a successful cast, the internal std::vector is left in an empty state.
+    ///
+    /// @return the reinterpreted vector, or std::nullopt if the block can't hold `U` elements.
+    template<typename U>
+    [[nodiscard]] std::optional<rebind_vec<U>> cast_into() noexcept
+    {
+        using UAlloc = typename rebind_vec<U>::allocator_type;
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_copyable_v<U>,
+                      "Only trivially copyable types can be reinterpreted as each other");
+        // Over-aligned blocks are freed with the alignment of the element type, which must match
+        static_assert(!std::is_same_v<Alloc, std::allocator<T>> || alignof(T) == alignof(U) ||
+                          (alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ &&
+                           alignof(U) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__),
+                      "std::allocator frees over-aligned types with their own alignment");
+
+        pointer data = m_inner.get_data_start();
+        const auto size_bytes = m_inner.inner.size() * sizeof(T);
+        const auto capacity_bytes = m_inner.inner.capacity() * sizeof(T);
+        if (size_bytes % sizeof(U) != 0 || capacity_bytes % sizeof(U) != 0 ||
+            reinterpret_cast<uintptr_t>(data) % alignof(U) != 0)
+        {
+            return std::nullopt;
+        }
+
+        auto alloc = UAlloc(m_inner.inner.get_allocator());
+        m_inner.unsafe_set_data_start(nullptr);
+        m_inner.unsafe_set_size(0);
+        m_inner.unsafe_set_capacity(0);
+        return Vec<U, UAlloc>(detail::VecWrapper<U, UAlloc>::unsafe_from_parts(
+            reinterpret_cast<U*>(data), size_bytes / sizeof(U), capacity_bytes / sizeof(U), alloc));
     }
 };  // class Vec
 }  // namespace leaky
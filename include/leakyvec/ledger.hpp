@@ -0,0 +1,227 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <new>
+#include <typeinfo>
+#include <unordered_set>
+
+// This header is usable on its own, but leaky::Vec only reports leaks and reclaims to the ledger
+// when LEAKY_ENABLE_LEDGER is defined (see leakyvec.hpp). All translation units of a program must
+// agree on it.
+
+namespace leaky {
+namespace ledger {
+
+    /// @brief The memory leaked by `leaky::Vec` and not reclaimed yet
+    struct Counters
+    {
+        int64_t bytes;    ///< total capacity of the outstanding buffers, in bytes
+        int64_t buffers;  ///< number of outstanding buffers
+    };
+
+    /// @brief Called when a pointer is reclaimed that isn't outstanding, when tracking pointers
+    using ReclaimHandler = void (*)(const std::type_info& type, const void* ptr);
+
+    namespace detail {
+        constexpr size_t shard_count = 16;
+
+        /// @brief Counters on their own cache line, so that threads don't contend for them
+        struct alignas(64) Shard
+        {
+            std::atomic<int64_t> bytes{0};
+            std::atomic<int64_t> buffers{0};
+        };
+
+        struct TypeEntry
+        {
+            const std::type_info& type;
+            Shard shards[shard_count];
+            TypeEntry* next;
+        };
+
+        /// @brief Spread threads over the shards, round-robin
+        inline size_t this_thread_shard() noexcept
+        {
+            static std::atomic<size_t> next_shard{0};
+            thread_local const size_t shard =
+                next_shard.fetch_add(1, std::memory_order_relaxed) % shard_count;
+            return shard;
+        }
+
+        /// @brief The intrusive list of every element type that's been leaked so far
+        inline std::atomic<TypeEntry*>& registry() noexcept
+        {
+            static std::atomic<TypeEntry*> head{nullptr};
+            return head;
+        }
+
+        template<typename T>
+        TypeEntry& entry_of() noexcept
+        {
+            static TypeEntry entry{typeid(T), {}, nullptr};
+            static const bool registered = [] {
+                auto& head = registry();
+                entry.next = head.load(std::memory_order_relaxed);
+                while (!head.compare_exchange_weak(
+                    entry.next, &entry, std::memory_order_release, std::memory_order_relaxed))
+                {
+                }
+                return true;
+            }();
+            static_cast<void>(registered);
+            return entry;
+        }
+
+        inline Counters sum(const Shard (&shards)[shard_count]) noexcept
+        {
+            auto counters = Counters{0, 0};
+            for (const auto& shard : shards)
+            {
+                counters.bytes += shard.bytes.load(std::memory_order_relaxed);
+                counters.buffers += shard.buffers.load(std::memory_order_relaxed);
+            }
+            return counters;
+        }
+
+        inline void default_reclaim_handler(const std::type_info& type, const void* ptr)
+        {
+            std::fprintf(stderr,
+                         "leakyvec: reclaimed %p (%s), which isn't outstanding; it was reclaimed "
+                         "twice, or leaked elsewhere\n",
+                         ptr,
+                         type.name());
+        }
+
+        struct PointerTracker
+        {
+            std::atomic<bool> enabled{false};
+            std::atomic<ReclaimHandler> handler{&default_reclaim_handler};
+            std::mutex mutex;
+            std::unordered_set<const void*> outstanding;
+        };
+
+        inline PointerTracker& tracker() noexcept
+        {
+            static PointerTracker tracker;
+            return tracker;
+        }
+    }  // namespace detail
+
+    /// @brief Record that a buffer of `capacity` elements of type `T` was leaked
+    template<typename T>
+    void on_leak(const void* ptr, size_t capacity) noexcept
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+        auto& shard = detail::entry_of<T>().shards[detail::this_thread_shard()];
+        const auto bytes = static_cast<int64_t>(capacity * sizeof(T));
+        shard.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        shard.buffers.fetch_add(1, std::memory_order_relaxed);
+
+        auto& tracker = detail::tracker();
+        if (tracker.enabled.load(std::memory_order_relaxed))
+        {
+            const auto lock = std::lock_guard<std::mutex>(tracker.mutex);
+            try
+            {
+                tracker.outstanding.insert(ptr);
+            } catch (const std::bad_alloc&)
+            {
+                // Losing track of a pointer is better than terminating
+            }
+        }
+    }
+
+    /// @brief Record that a buffer of `capacity` elements of type `T` was reclaimed
+    ///
+    /// `leaky::Vec` calls this when it's reconstructed from its parts. Call it before deallocating
+    /// leaked parts manually, to keep the counters accurate.
+    template<typename T>
+    void on_reclaim(const void* ptr, size_t capacity) noexcept
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+
+        auto& tracker = detail::tracker();
+        if (tracker.enabled.load(std::memory_order_relaxed))
+        {
+            auto lock = std::unique_lock<std::mutex>(tracker.mutex);
+            if (tracker.outstanding.erase(ptr) == 0)
+            {
+                lock.unlock();
+                tracker.handler.load()(typeid(T), ptr);
+                return;
+            }
+        }
+
+        auto& shard = detail::entry_of<T>().shards[detail::this_thread_shard()];
+        const auto bytes = static_cast<int64_t>(capacity * sizeof(T));
+        shard.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        shard.buffers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// @brief The outstanding buffers of element type `T`
+    template<typename T>
+    [[nodiscard]] Counters outstanding() noexcept
+    {
+        return detail::sum(detail::entry_of<T>().shards);
+    }
+
+    /// @brief Call `fn(const std::type_info&, Counters)` for every element type leaked so far
+    template<typename Fn>
+    void for_each_type(Fn&& fn)
+    {
+        for (auto* entry = detail::registry().load(std::memory_order_acquire); entry != nullptr;
+             entry = entry->next)
+        {
+            fn(entry->type, detail::sum(entry->shards));
+        }
+    }
+
+    /// @brief The outstanding buffers of every element type, e.g., for a "bytes in flight" gauge
+    [[nodiscard]] inline Counters total_outstanding() noexcept
+    {
+        auto total = Counters{0, 0};
+        for_each_type([&total](const std::type_info&, Counters counters) {
+            total.bytes += counters.bytes;
+            total.buffers += counters.buffers;
+        });
+        return total;
+    }
+
+    /// @brief Track every outstanding pointer, to detect reclaiming a buffer twice
+    ///
+    /// This takes a global lock on every leak and reclaim. Reclaiming a pointer that isn't
+    /// outstanding calls the reclaim handler instead of updating the counters. Pointers leaked
+    /// while tracking was disabled aren't outstanding, so enable it before leaking any.
+    ///
+    /// @note Memory leaked by another language or process and reclaimed with `from_c()` isn't
+    ///       outstanding either.
+    inline void set_track_pointers(bool enabled) noexcept
+    {
+        auto& tracker = detail::tracker();
+        const auto lock = std::lock_guard<std::mutex>(tracker.mutex);
+        tracker.enabled.store(enabled, std::memory_order_relaxed);
+        if (!enabled)
+        {
+            tracker.outstanding.clear();
+        }
+    }
+
+    /// @brief Replace the handler called when a pointer is reclaimed that isn't outstanding
+    ///
+    /// The default handler prints a message to stderr.
+    inline void set_reclaim_handler(ReclaimHandler handler) noexcept
+    {
+        detail::tracker().handler.store(handler != nullptr ? handler
+                                                           : &detail::default_reclaim_handler);
+    }
+}  // namespace ledger
+}  // namespace leaky
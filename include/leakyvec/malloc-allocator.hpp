@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace leaky {
+
+/// @brief A stateless allocator that allocates with malloc and deallocates with free
+///
+/// Memory allocated by `std::allocator` comes from `operator new`, which isn't guaranteed to be
+/// compatible with anything but `operator delete`. Memory allocated by this allocator can be freed
+/// with `free()`, and so by any other allocator built on it, like Rust's `std::alloc::System` on
+/// POSIX platforms. This makes it safe to hand a vector leaked with `leaky::Vec<T,
+/// MallocAllocator<T>>` to a Rust `Vec<T>` that uses the default global allocator.
+///
+/// Over-aligned types are allocated with `std::aligned_alloc`, which can also be freed with
+/// `free()`.
+///
+/// @note MSVC doesn't provide `std::aligned_alloc`, and memory from `_aligned_malloc` can't be
+/// freed with `free()`, so over-aligned types are not supported on Windows.
+template<typename T>
+struct MallocAllocator
+{
+    using value_type = T;
+
+    MallocAllocator() noexcept = default;
+    template<typename U>
+    constexpr MallocAllocator(const MallocAllocator<U>&) noexcept
+    {
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+
+        void* p = nullptr;
+        if constexpr (alignof(T) <= alignof(std::max_align_t))
+        {
+            p = std::malloc(n * sizeof(T));
+        } else
+        {
+            // std::aligned_alloc requires the size to be a multiple of the alignment
+            const auto bytes = (n * sizeof(T) + alignof(T) - 1) / alignof(T) * alignof(T);
+            p = std::aligned_alloc(alignof(T), bytes);
+        }
+
+        if (p == nullptr && n != 0)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t /*n*/) noexcept { std::free(p); }
+
+    /// @brief Grow or shrink an allocation with `realloc()`, relocating its bytes if it moves
+    ///
+    /// @note Only meaningful for trivially copyable types. Over-aligned types can't use
+    /// `realloc()`, which doesn't preserve alignment, so they're copied into a new allocation.
+    [[nodiscard]] T* reallocate(T* p, std::size_t old_n, std::size_t new_n)
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "Only trivially copyable types can be relocated with realloc()");
+        if (new_n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+
+        if constexpr (alignof(T) <= alignof(std::max_align_t))
+        {
+            void* new_p = std::realloc(p, new_n * sizeof(T));
+            if (new_p == nullptr && new_n != 0)
+            {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(new_p);
+        } else
+        {
+            T* new_p = allocate(new_n);
+            std::memcpy(new_p, p, (old_n < new_n ? old_n : new_n) * sizeof(T));
+            deallocate(p, old_n);
+            return new_p;
+        }
+    }
+};
+
+template<class T, class U>
+constexpr bool operator==(const MallocAllocator<T>&, const MallocAllocator<U>&) noexcept
+{
+    return true;
+}
+
+template<class T, class U>
+constexpr bool operator!=(const MallocAllocator<T>&, const MallocAllocator<U>&) noexcept
+{
+    return false;
+}
+}  // namespace leaky
@@ -0,0 +1,540 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace leaky {
+
+/// @brief A leaked vector's memory in an anonymous memory file, as sent to another process
+///
+/// The vector's data block is `cap` elements of `elem_size` bytes, starting `offset` bytes into the
+/// file, of which the first `len` are initialized. `offset` is a multiple of the page size.
+struct MemfdDescriptor
+{
+    int fd;              ///< the memory file descriptor, owned by whoever holds the descriptor
+    uint64_t offset;     ///< offset of the data block in the file, in bytes
+    uint64_t len;        ///< number of initialized elements
+    uint64_t cap;        ///< number of allocated elements
+    uint64_t elem_size;  ///< sizeof(T) in bytes
+};
+
+template<typename T>
+class MemfdAllocator;
+
+/// @brief An anonymous memory file, created with `memfd_create()`, that backs vectors
+///
+/// Every block is mapped from its own page-aligned region of the file, so the blocks of a growing
+/// vector, or of a vector and its copy, never overlap. New regions are appended at the end of the
+/// file. Freeing a block unmaps it and punches its region out of the file, releasing its memory,
+/// unless the block was shared with `memfd_descriptor()` or received from another process, which
+/// may still map it.
+///
+/// The file descriptor is closed when the last MemfdAllocator referring to it is destroyed. The
+/// memory itself lives until every process closes its descriptor and unmaps it.
+class SharedMemory
+{
+  private:
+    struct Region
+    {
+        uint64_t offset;
+        /// Whether another process may map the region, so it must keep its pages when freed
+        bool shared;
+    };
+
+    int m_fd;
+    std::mutex m_mutex;
+    /// The offset of the next region, at the end of the file
+    uint64_t m_end;
+    /// The region of every block mapped from the file
+    std::unordered_map<const void*, Region> m_regions;
+
+    template<typename T>
+    friend class MemfdAllocator;
+
+    template<typename T>
+    friend MemfdDescriptor
+    memfd_descriptor(const std::tuple<T*, size_t, size_t, MemfdAllocator<T>>& parts) noexcept;
+
+    template<typename T>
+    friend std::tuple<T*, size_t, size_t, MemfdAllocator<T>>
+    parts_from_memfd(const MemfdDescriptor& desc);
+
+    /// @brief Map `length` bytes at `offset`, and remember where the block came from
+    ///
+    /// @return the mapping, or nullptr if it failed
+    void* map_region(uint64_t offset, size_t length, bool shared) noexcept
+    {
+        void* base = mmap(nullptr,
+                          length,
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED,
+                          m_fd,
+                          static_cast<off_t>(offset));
+        if (base == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        try
+        {
+            m_regions.emplace(base, Region{offset, shared});
+        } catch (const std::bad_alloc&)
+        {
+            munmap(base, length);
+            return nullptr;
+        }
+        return base;
+    }
+
+    /// @brief Grow the file by a new region of `length` bytes, and map it
+    ///
+    /// @throws std::bad_alloc if the file can't be grown or mapped
+    void* allocate_region(size_t length)
+    {
+        const auto lock = std::lock_guard<std::mutex>(m_mutex);
+        const auto offset = m_end;
+        if (ftruncate(m_fd, static_cast<off_t>(offset + length)) != 0)
+        {
+            throw std::bad_alloc();
+        }
+        void* base = map_region(offset, length, false);
+        if (base == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        m_end = offset + length;
+        return base;
+    }
+
+    /// @brief Unmap a block, and release its memory unless it's shared
+    void deallocate_region(void* base, size_t length) noexcept
+    {
+        const auto lock = std::lock_guard<std::mutex>(m_mutex);
+        const auto it = m_regions.find(base);
+        LEAKY_DEBUG_ASSERT(it != m_regions.end());
+        if (it != m_regions.end())
+        {
+            if (!it->second.shared)
+            {
+                static_cast<void>(fallocate(m_fd,
+                                            FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                                            static_cast<off_t>(it->second.offset),
+                                            static_cast<off_t>(length)));
+            }
+            m_regions.erase(it);
+        }
+        const int result = munmap(base, length);
+        LEAKY_DEBUG_ASSERT(result == 0);
+        static_cast<void>(result);
+    }
+
+    /// @brief Mark a block as shared with another process, and get its offset in the file
+    uint64_t share_region(const void* base) noexcept
+    {
+        const auto lock = std::lock_guard<std::mutex>(m_mutex);
+        const auto it = m_regions.find(base);
+        LEAKY_DEBUG_ASSERT(it != m_regions.end());
+        if (it == m_regions.end())
+        {
+            return 0;
+        }
+        it->second.shared = true;
+        return it->second.offset;
+    }
+
+  public:
+    SharedMemory(int fd, uint64_t end) noexcept : m_fd(fd), m_end(end) {}
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+    ~SharedMemory() noexcept { ::close(m_fd); }
+
+    /// @brief Create a new, empty memory file. The name only shows up in `/proc/<pid>/fd`.
+    ///
+    /// @throws std::system_error if the file can't be created
+    static std::shared_ptr<SharedMemory> create(const char* name = "leakyvec")
+    {
+        const int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "memfd_create");
+        }
+        return adopt(fd);
+    }
+
+    /// @brief Take ownership of a memory file descriptor, e.g., one received from another process
+    ///
+    /// New blocks are allocated after the file's current end.
+    ///
+    /// The descriptor is closed if this throws.
+    /// @throws std::system_error if the file's size can't be read
+    static std::shared_ptr<SharedMemory> adopt(int fd)
+    {
+        struct stat file_stat = {};
+        if (fstat(fd, &file_stat) != 0)
+        {
+            const auto error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "fstat");
+        }
+        const auto page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        const auto end = (static_cast<uint64_t>(file_stat.st_size) + page - 1) / page * page;
+        try
+        {
+            return std::make_shared<SharedMemory>(fd, end);
+        } catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    [[nodiscard]] int fd() const noexcept { return m_fd; }
+};
+
+/// @brief A stateful allocator that allocates a vector's memory in an anonymous memory file
+///
+/// This works like `FileAllocator`, without the header and without touching the disk: each
+/// allocation grows the file by a new region, and maps it. The memory can be handed to another
+/// process as a page mapping, by sending the file descriptor with `send_memfd()`, rather than
+/// copying the elements through a socket.
+///
+/// @tparam T the element type, which must be trivially copyable to be shared with another process
+///
+/// @note Once a memory file is sent, only one process may allocate from it, since the processes
+/// don't coordinate where the file ends. This allocator is Linux-only.
+template<typename T>
+class MemfdAllocator
+{
+  private:
+    std::shared_ptr<SharedMemory> m_memory;
+
+    template<typename U>
+    friend class MemfdAllocator;
+
+  public:
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Only trivially copyable types can be shared with another process");
+
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    explicit MemfdAllocator(std::shared_ptr<SharedMemory> memory) noexcept :
+        m_memory(std::move(memory))
+    {
+    }
+    template<typename U>
+    MemfdAllocator(const MemfdAllocator<U>& other) noexcept : m_memory(other.m_memory)
+    {
+    }
+
+    [[nodiscard]] const std::shared_ptr<SharedMemory>& memory() const noexcept { return m_memory; }
+
+    /// @brief The length, in bytes, of the region and mapping that back an allocation of `n`
+    /// elements
+    [[nodiscard]] static size_t mapping_length(size_t n) noexcept
+    {
+        const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return (n * sizeof(T) + page - 1) / page * page;
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        if (n > (std::numeric_limits<std::size_t>::max() / 2) / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        if (n == 0)
+        {
+            return nullptr;
+        }
+        return static_cast<T*>(m_memory->allocate_region(mapping_length(n)));
+    }
+
+    /// @brief Unmap the vector's memory; shared memory lives on while it's mapped elsewhere
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (p != nullptr)
+        {
+            m_memory->deallocate_region(p, mapping_length(n));
+        }
+    }
+
+    /// @brief The capacity of a block allocated for `n` elements, up to the end of its last page
+    [[nodiscard]] std::size_t usable_capacity(T* /*p*/, std::size_t n) const noexcept
+    {
+        return mapping_length(n) / sizeof(T);
+    }
+
+    template<class U>
+    bool operator==(const MemfdAllocator<U>& other) const noexcept
+    {
+        return m_memory == other.m_memory;
+    }
+
+    template<class U>
+    bool operator!=(const MemfdAllocator<U>& other) const noexcept
+    {
+        return m_memory != other.m_memory;
+    }
+};
+
+/// @brief Create an empty std::vector whose memory will be allocated in a new memory file
+///
+/// @throws std::system_error if the memory file can't be created
+template<typename T>
+[[nodiscard]] std::vector<T, MemfdAllocator<T>> make_memfd_vec(const char* name = "leakyvec")
+{
+    return std::vector<T, MemfdAllocator<T>>(MemfdAllocator<T>(SharedMemory::create(name)));
+}
+
+/// @brief Describe a leaked memfd-backed vector, to send it to another process
+///
+/// The descriptor borrows the file descriptor of the parts' allocator, so the parts must outlive
+/// it until it's sent. The vector's block keeps its memory when it's freed by this process, since
+/// the receiver may still map it.
+template<typename T>
+[[nodiscard]] MemfdDescriptor
+memfd_descriptor(const std::tuple<T*, size_t, size_t, MemfdAllocator<T>>& parts) noexcept
+{
+    const auto& [data, size, capacity, alloc] = parts;
+    auto& memory = *alloc.memory();
+    const auto offset = data == nullptr ? 0 : memory.share_region(data);
+    return MemfdDescriptor{memory.fd(), offset, size, capacity, sizeof(T)};
+}
+
+namespace detail {
+    /// @brief Check that a received memory file holds the whole data block, and can't shrink
+    ///
+    /// A sender could otherwise truncate the file, and crash the receiver with SIGBUS when it
+    /// touches the pages past the end.
+    inline void check_memfd(const MemfdDescriptor& desc, size_t elem_size)
+    {
+        constexpr auto max_length = std::numeric_limits<uint64_t>::max() / 2;
+        const auto page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        const int seals = fcntl(desc.fd, F_GET_SEALS);
+        struct stat file_stat = {};
+        if (desc.elem_size != elem_size || desc.len > desc.cap || desc.offset % page != 0 ||
+            desc.offset > max_length || desc.cap > (max_length - desc.offset) / elem_size ||
+            seals < 0 || (seals & F_SEAL_SHRINK) == 0 || fstat(desc.fd, &file_stat) != 0 ||
+            static_cast<uint64_t>(file_stat.st_size) < desc.offset + desc.cap * elem_size)
+        {
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "memfd");
+        }
+    }
+}  // namespace detail
+
+/// @brief Send a memory file descriptor, and its description, over a Unix domain socket
+///
+/// The descriptor travels as `SCM_RIGHTS` ancillary data, so the receiver gets its own descriptor
+/// for the same memory. The memory file is sealed against shrinking first, so the receiver can
+/// safely map it. The sender keeps its own descriptor.
+///
+/// @throws std::system_error if the file can't be sealed, or the message can't be sent
+inline void send_memfd(int socket, const MemfdDescriptor& desc)
+{
+    if (fcntl(desc.fd, F_ADD_SEALS, F_SEAL_SHRINK) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "fcntl(F_ADD_SEALS)");
+    }
+
+    auto payload = desc;
+    iovec iov{&payload, sizeof(payload)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &desc.fd, sizeof(int));
+
+    ssize_t sent = 0;
+    do
+    {
+        sent = sendmsg(socket, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != static_cast<ssize_t>(sizeof(payload)))
+    {
+        throw std::system_error(sent < 0 ? errno : EMSGSIZE, std::generic_category(), "sendmsg");
+    }
+}
+
+/// @brief Receive a memory file descriptor, and its description, sent by `send_memfd()`
+///
+/// @return the description, with the received file descriptor, which the caller owns
+/// @throws std::system_error if the message can't be received, or doesn't carry a descriptor
+[[nodiscard]] inline MemfdDescriptor recv_memfd(int socket)
+{
+    MemfdDescriptor payload{};
+    iovec iov{&payload, sizeof(payload)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received = 0;
+    do
+    {
+        received = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "recvmsg");
+    }
+
+    int fd = -1;
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(sizeof(int)))
+    {
+        std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    if (fd < 0 || received != static_cast<ssize_t>(sizeof(payload)) ||
+        (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        throw std::system_error(std::make_error_code(std::errc::bad_message), "recv_memfd");
+    }
+    payload.fd = fd;
+    return payload;
+}
+
+/// @brief Map a received memory file, and return it as parts for `Vec::from_parts()`
+///
+/// The reconstructed vector owns the mapping, and can be modified and grown like the original.
+/// Writes are shared with the sender if it still maps the memory.
+///
+/// @note This takes ownership of `desc.fd`, even if it throws.
+/// @throws std::system_error if the memory file doesn't hold a vector of `T`, isn't sealed
+/// against shrinking, or can't be mapped
+template<typename T>
+[[nodiscard]] std::tuple<T*, size_t, size_t, MemfdAllocator<T>>
+parts_from_memfd(const MemfdDescriptor& desc)
+{
+    auto memory = SharedMemory::adopt(desc.fd);
+    detail::check_memfd(desc, sizeof(T));
+
+    const auto cap = static_cast<size_t>(desc.cap);
+    if (cap == 0)
+    {
+        return std::make_tuple(
+            static_cast<T*>(nullptr), size_t{0}, size_t{0}, MemfdAllocator<T>(std::move(memory)));
+    }
+
+    const auto lock = std::lock_guard<std::mutex>(memory->m_mutex);
+    // The sender may still map the block, so it keeps its memory when it's freed
+    void* data = memory->map_region(desc.offset, MemfdAllocator<T>::mapping_length(cap), true);
+    if (data == nullptr)
+    {
+        throw std::system_error(errno, std::generic_category(), "mmap");
+    }
+    return std::make_tuple(static_cast<T*>(data),
+                           static_cast<size_t>(desc.len),
+                           cap,
+                           MemfdAllocator<T>(std::move(memory)));
+}
+
+/// @brief A read-only mapping of a received vector's initialized elements
+///
+/// Use this rather than `parts_from_memfd()` when the receiver only reads the elements: the pages
+/// are mapped read-only, so the receiver can't modify the sender's memory by mistake.
+///
+/// @tparam T the element type
+template<typename T>
+class MemfdView
+{
+  private:
+    const T* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_mapping_length = 0;
+
+  public:
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Only trivially copyable types can be shared with another process");
+
+    /// @brief Map a received memory file
+    ///
+    /// @note This takes ownership of `desc.fd`, and closes it once the memory is mapped, or if it
+    /// throws. The mapping keeps the memory alive.
+    /// @throws std::system_error if the memory file doesn't hold a vector of `T`, isn't sealed
+    /// against shrinking, or can't be mapped
+    explicit MemfdView(const MemfdDescriptor& desc)
+    {
+        const auto memory = SharedMemory::adopt(desc.fd);
+        detail::check_memfd(desc, sizeof(T));
+        if (desc.len == 0)
+        {
+            return;
+        }
+
+        const auto length = MemfdAllocator<T>::mapping_length(static_cast<size_t>(desc.len));
+        void* data = mmap(nullptr,
+                          length,
+                          PROT_READ,
+                          MAP_SHARED,
+                          memory->fd(),
+                          static_cast<off_t>(desc.offset));
+        if (data == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        m_data = static_cast<const T*>(data);
+        m_size = static_cast<size_t>(desc.len);
+        m_mapping_length = length;
+    }
+
+    MemfdView(MemfdView&& other) noexcept :
+        m_data(std::exchange(other.m_data, nullptr)),
+        m_size(std::exchange(other.m_size, 0)),
+        m_mapping_length(std::exchange(other.m_mapping_length, 0))
+    {
+    }
+    MemfdView(const MemfdView&) = delete;
+    MemfdView& operator=(const MemfdView&) = delete;
+    MemfdView& operator=(MemfdView&&) = delete;
+
+    ~MemfdView() noexcept
+    {
+        if (m_data != nullptr)
+        {
+            munmap(const_cast<T*>(m_data), m_mapping_length);
+        }
+    }
+
+    [[nodiscard]] const T* data() const noexcept { return m_data; }
+    [[nodiscard]] size_t size() const noexcept { return m_size; }
+    [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] const T* begin() const noexcept { return m_data; }
+    [[nodiscard]] const T* end() const noexcept { return m_data + m_size; }
+    [[nodiscard]] const T& operator[](size_t i) const noexcept { return m_data[i]; }
+};
+}  // namespace leaky
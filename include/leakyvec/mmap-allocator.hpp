@@ -0,0 +1,224 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace leaky {
+
+/// @brief How an MmapAllocator should back its mappings with huge pages
+enum class HugePages : uint8_t
+{
+    /// Use the regular page size
+    None,
+    /// Use the regular page size, but advise the kernel to use transparent huge pages with
+    /// `MADV_HUGEPAGE`. This is only a hint, and the kernel may ignore it.
+    Transparent,
+    /// Map explicit huge pages with `MAP_HUGETLB`. This fails to allocate unless the system has
+    /// enough huge pages of the requested size reserved.
+    Explicit,
+};
+
+/// @brief Options for how an MmapAllocator maps its memory
+struct MmapOptions
+{
+    HugePages huge_pages = HugePages::None;
+    /// Pre-fault the mapping with `MAP_POPULATE`, so the first access doesn't page fault
+    bool populate = false;
+    /// The huge page size to request with `HugePages::Explicit`. Must be a power of two supported
+    /// by the system, typically 2 MiB or 1 GiB.
+    size_t huge_page_size = size_t{2} << 20;
+};
+
+/// @brief A stateful allocator that gives each allocation its own anonymous private mapping
+///
+/// This is intended for very large vectors, where backing them with huge pages and pre-faulting
+/// them avoids TLB misses and page fault storms.
+///
+/// Each mapping is rounded up to a whole number of pages. The allocator part of
+/// `leaky::Vec::leak()` knows the page size, so a receiver that doesn't rebuild the vector can free
+/// it with
+///
+/// ```cpp
+/// auto [data, size, capacity, alloc] = leaky_vec.leak();
+/// munmap(data, alloc.mapping_length(capacity));
+/// ```
+///
+/// @note This allocator is only available on POSIX platforms, and the huge page and populate
+/// options are Linux-specific.
+template<typename T>
+class MmapAllocator
+{
+  private:
+    MmapOptions m_options;
+
+    template<typename U>
+    friend class MmapAllocator;
+
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    explicit MmapAllocator(MmapOptions options = MmapOptions{}) noexcept : m_options(options) {}
+    template<typename U>
+    MmapAllocator(const MmapAllocator<U>& other) noexcept : m_options(other.m_options)
+    {
+    }
+
+    [[nodiscard]] const MmapOptions& options() const noexcept { return m_options; }
+
+    /// @brief The size of the pages backing this allocator's mappings, in bytes
+    [[nodiscard]] size_t page_size() const noexcept
+    {
+        if (m_options.huge_pages == HugePages::Explicit)
+        {
+            return m_options.huge_page_size;
+        }
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    /// @brief The length, in bytes, of the mapping that backs an allocation of `n` elements
+    ///
+    /// This is the length to pass to `munmap()` to free a leaked vector's memory.
+    [[nodiscard]] size_t mapping_length(size_t n) const noexcept
+    {
+        const auto page = page_size();
+        return (n * sizeof(T) + page - 1) / page * page;
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        // Leave room to round the mapping up to a whole page
+        if (n > (std::numeric_limits<std::size_t>::max() - page_size()) / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        if (n == 0)
+        {
+            return nullptr;
+        }
+
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+        if (m_options.populate)
+        {
+            flags |= MAP_POPULATE;
+        }
+#endif
+#ifdef MAP_HUGETLB
+        if (m_options.huge_pages == HugePages::Explicit)
+        {
+            // The log2 of the huge page size is encoded in the bits above MAP_HUGE_SHIFT
+            int log2_page_size = 0;
+            while ((size_t{1} << log2_page_size) < m_options.huge_page_size)
+            {
+                log2_page_size++;
+            }
+            flags |= MAP_HUGETLB | (log2_page_size << MAP_HUGE_SHIFT);
+        }
+#endif
+
+        const auto length = mapping_length(n);
+        void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+
+#ifdef MADV_HUGEPAGE
+        if (m_options.huge_pages == HugePages::Transparent)
+        {
+            // Only a hint; if transparent huge pages are disabled, the mapping still works
+            static_cast<void>(madvise(p, length, MADV_HUGEPAGE));
+        }
+#endif
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (p == nullptr)
+        {
+            return;
+        }
+        const int result = munmap(p, mapping_length(n));
+        LEAKY_DEBUG_ASSERT(result == 0);
+        static_cast<void>(result);
+    }
+
+    /// @brief Grow or shrink a mapping, letting the kernel move its pages rather than copying them
+    ///
+    /// On Linux this uses `mremap()`, which may move the mapping to a new address. Elsewhere, it
+    /// falls back to copying into a new mapping.
+    ///
+    /// @note Only meaningful for trivially copyable types.
+    [[nodiscard]] T* reallocate(T* p, std::size_t old_n, std::size_t new_n)
+    {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "Only trivially copyable types can be relocated with mremap()");
+        if (p == nullptr)
+        {
+            return allocate(new_n);
+        }
+        if (new_n == 0)
+        {
+            deallocate(p, old_n);
+            return nullptr;
+        }
+
+        const auto old_length = mapping_length(old_n);
+        if (new_n > (std::numeric_limits<std::size_t>::max() - page_size()) / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        const auto new_length = mapping_length(new_n);
+        if (old_length == new_length)
+        {
+            return p;
+        }
+
+#ifdef MREMAP_MAYMOVE
+        void* new_p = mremap(p, old_length, new_length, MREMAP_MAYMOVE);
+        if (new_p == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+    #ifdef MADV_HUGEPAGE
+        if (m_options.huge_pages == HugePages::Transparent)
+        {
+            static_cast<void>(madvise(new_p, new_length, MADV_HUGEPAGE));
+        }
+    #endif
+        return static_cast<T*>(new_p);
+#else
+        T* new_p = allocate(new_n);
+        std::memcpy(new_p, p, (old_n < new_n ? old_n : new_n) * sizeof(T));
+        deallocate(p, old_n);
+        return new_p;
+#endif
+    }
+
+    /// @brief Any two allocators with the same page size can free each other's mappings
+    template<class U>
+    bool operator==(const MmapAllocator<U>& other) const noexcept
+    {
+        return page_size() == other.page_size();
+    }
+
+    template<class U>
+    bool operator!=(const MmapAllocator<U>& other) const noexcept
+    {
+        return !(*this == other);
+    }
+};
+}  // namespace leaky
@@ -0,0 +1,201 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace leaky {
+
+/// @brief The raw parts of a leaked ragged array, in a flat CSR layout
+///
+/// Row `i` is made of the values in `[offsets[i], offsets[i + 1])`, so there's one more offset
+/// than there are rows, and the first offset is 0. With `int32_t` or `int64_t` offsets, the two
+/// buffers are laid out like an Arrow List or LargeList array's.
+///
+/// @tparam T the element type
+/// @tparam Alloc the allocator type of the values
+/// @tparam Offset the integer type of the offsets
+template<typename T, typename Alloc = typename std::vector<T>::allocator_type,
+         typename Offset = int64_t>
+struct NestedParts
+{
+    using offsets_allocator_type =
+        typename std::allocator_traits<Alloc>::template rebind_alloc<Offset>;
+    using offsets_type = std::tuple<typename std::vector<Offset, offsets_allocator_type>::pointer,
+                                    size_t,
+                                    size_t,
+                                    offsets_allocator_type>;
+    using values_type = std::tuple<typename std::vector<T, Alloc>::pointer, size_t, size_t, Alloc>;
+
+    offsets_type offsets;
+    values_type values;
+
+    /// @brief The number of rows
+    [[nodiscard]] size_t rows() const noexcept { return std::get<1>(offsets) - 1; }
+};
+
+/// @brief A builder that appends ragged rows straight into a flat values buffer
+///
+/// Values are appended to the current row, and `finish_row()` closes it. Nothing is ever stored
+/// as a vector of vectors, so building the rows costs two growing buffers rather than one
+/// allocation per row.
+///
+/// @tparam T the element type
+/// @tparam Alloc the allocator type of the values. The offsets use it rebound to `Offset`.
+/// @tparam Offset the integer type of the offsets
+template<typename T, typename Alloc = typename std::vector<T>::allocator_type,
+         typename Offset = int64_t>
+class NestedBuilder
+{
+  public:
+    using parts_type = NestedParts<T, Alloc, Offset>;
+    using offsets_allocator_type = typename parts_type::offsets_allocator_type;
+
+  private:
+    static_assert(std::is_integral_v<Offset>, "The offsets must be integers");
+
+    std::vector<Offset, offsets_allocator_type> m_offsets;
+    std::vector<T, Alloc> m_values;
+
+    NestedBuilder(std::vector<Offset, offsets_allocator_type>&& offsets,
+                  std::vector<T, Alloc>&& values) noexcept
+        : m_offsets(std::move(offsets)), m_values(std::move(values))
+    {
+    }
+
+  public:
+    /// @brief Create a builder with no rows
+    ///
+    /// @throws std::bad_alloc if the first offset can't be allocated
+    explicit NestedBuilder(const Alloc& alloc = Alloc())
+        : m_offsets(1, Offset{0}, offsets_allocator_type(alloc)), m_values(alloc)
+    {
+    }
+
+    /// @brief Reserve space for `rows` more rows, and `values` more values, in total
+    void reserve(size_t rows, size_t values)
+    {
+        m_offsets.reserve(m_offsets.size() + rows);
+        m_values.reserve(m_values.size() + values);
+    }
+
+    /// @brief The number of finished rows
+    [[nodiscard]] size_t rows() const noexcept { return m_offsets.size() - 1; }
+
+    [[nodiscard]] const std::vector<Offset, offsets_allocator_type>& offsets() const noexcept
+    {
+        return m_offsets;
+    }
+
+    /// @brief The values of every row, including the values appended to the current row
+    [[nodiscard]] const std::vector<T, Alloc>& values() const noexcept { return m_values; }
+
+    /// @brief Append a value to the current row
+    template<typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        return m_values.emplace_back(std::forward<Args>(args)...);
+    }
+
+    void push_back(const T& value) { m_values.push_back(value); }
+    void push_back(T&& value) { m_values.push_back(std::move(value)); }
+
+    /// @brief Append a range of values to the current row
+    template<typename InputIt>
+    void append(InputIt first, InputIt last)
+    {
+        m_values.insert(m_values.end(), first, last);
+    }
+
+    /// @brief Close the current row, which may be empty
+    ///
+    /// @throws std::length_error if the number of values doesn't fit in `Offset`
+    void finish_row()
+    {
+        if (m_values.size() > static_cast<size_t>(std::numeric_limits<Offset>::max()))
+        {
+            throw std::length_error("leaky::NestedBuilder: too many values for the offset type");
+        }
+        m_offsets.push_back(static_cast<Offset>(m_values.size()));
+    }
+
+    /// @brief Append a whole row, copying the values of the range
+    template<typename Range>
+    void push_row(const Range& row)
+    {
+        append(std::begin(row), std::end(row));
+        finish_row();
+    }
+
+    /// @brief Leak the offsets and values buffers
+    ///
+    /// Values appended after the last `finish_row()` must be in a finished row first.
+    ///
+    /// @note After calling this method, the builder is left in an unusable, empty state.
+    [[nodiscard]] parts_type leak() && noexcept
+    {
+        LEAKY_DEBUG_ASSERT(static_cast<size_t>(m_offsets.back()) == m_values.size());
+        auto offsets = Vec<Offset, offsets_allocator_type>(std::move(m_offsets));
+        auto values = Vec<T, Alloc>(std::move(m_values));
+        return parts_type{std::move(offsets).leak(), std::move(values).leak()};
+    }
+
+    /// @brief Reconstruct a builder from parts returned by `leak()`, to append more rows to them
+    /// or to free them
+    [[nodiscard]] static NestedBuilder from_parts(parts_type&& parts) noexcept
+    {
+        return NestedBuilder(
+            Vec<Offset, offsets_allocator_type>::from_parts(std::move(parts.offsets)).take(),
+            Vec<T, Alloc>::from_parts(std::move(parts.values)).take());
+    }
+
+    /// @brief Take the offsets and values buffers
+    ///
+    /// @note After calling this method, the builder is left in an unusable, empty state.
+    [[nodiscard]] std::pair<std::vector<Offset, offsets_allocator_type>, std::vector<T, Alloc>>
+    take() && noexcept
+    {
+        return {std::move(m_offsets), std::move(m_values)};
+    }
+};
+
+/// @brief Flatten a range of std::vectors into one values buffer and its offsets, and leak both
+///
+/// The values are moved into a single buffer, allocated once for the total size, so each inner
+/// vector is left in a valid but unspecified state.
+///
+/// @throws std::bad_alloc if the buffers can't be allocated, or std::length_error if there are
+///         more values than `Offset` can count
+template<typename Offset = int64_t,
+         typename Range,
+         typename Vector = std::remove_reference_t<decltype(*std::begin(std::declval<Range&>()))>,
+         typename T = typename Vector::value_type,
+         typename Alloc = typename Vector::allocator_type>
+[[nodiscard]] NestedParts<T, Alloc, Offset> leak_nested(Range& rows, const Alloc& alloc = Alloc())
+{
+    size_t row_count = 0;
+    size_t value_count = 0;
+    for (const auto& row : rows)
+    {
+        row_count++;
+        value_count += row.size();
+    }
+
+    auto builder = NestedBuilder<T, Alloc, Offset>(alloc);
+    builder.reserve(row_count, value_count);
+    for (auto& row : rows)
+    {
+        builder.append(std::make_move_iterator(row.begin()), std::make_move_iterator(row.end()));
+        builder.finish_row();
+    }
+    return std::move(builder).leak();
+}
+}  // namespace leaky
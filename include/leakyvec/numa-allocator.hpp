@@ -0,0 +1,238 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <numa.h>
+#include <numaif.h>
+#include <unistd.h>
+
+namespace leaky {
+
+/// @brief Where a NumaAllocator places its memory
+enum class NumaPlacement : uint8_t
+{
+    /// On the node of the CPU that allocates it
+    Local,
+    /// On a chosen node
+    Node,
+    /// Spread page by page over every node, for data that's read from every socket
+    Interleaved,
+};
+
+/// @brief A stateful allocator that places each allocation on a chosen NUMA node, with libnuma
+///
+/// Allocations are page-granular mappings (`numa_alloc_onnode()` and friends), so this is meant
+/// for large vectors, and `leaky::Vec` reports the whole pages as the leaked capacity. The
+/// allocator is the last element of the parts returned by `leaky::Vec::leak()`, so the receiver
+/// knows which node holds the data from `node()`, e.g., to schedule its consumer on that node.
+/// `move_to_node()` migrates a leaked vector's pages at handoff, and updates its allocator.
+///
+/// Any allocator can free any other's memory, whatever its placement, so they all compare equal.
+///
+/// @note This allocator is Linux-only, and requires linking with libnuma (`-lnuma`). On a kernel
+/// without NUMA support, the placement is ignored.
+template<typename T>
+class NumaAllocator
+{
+  private:
+    NumaPlacement m_placement;
+    int m_node;
+
+    template<typename U>
+    friend class NumaAllocator;
+
+    NumaAllocator(NumaPlacement placement, int node) noexcept : m_placement(placement), m_node(node)
+    {
+    }
+
+  public:
+    using value_type = T;
+    // The placement goes wherever the memory goes
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    /// @brief An allocator that places memory on the allocating CPU's node
+    NumaAllocator() noexcept : NumaAllocator(NumaPlacement::Local, -1) {}
+    template<typename U>
+    NumaAllocator(const NumaAllocator<U>& other) noexcept :
+        m_placement(other.m_placement), m_node(other.m_node)
+    {
+    }
+
+    /// @brief An allocator that places memory on `node`
+    [[nodiscard]] static NumaAllocator on_node(int node) noexcept
+    {
+        LEAKY_DEBUG_ASSERT(node >= 0 && node <= numa_max_node());
+        return NumaAllocator(NumaPlacement::Node, node);
+    }
+
+    /// @brief An allocator that interleaves memory over every node
+    [[nodiscard]] static NumaAllocator interleaved() noexcept
+    {
+        return NumaAllocator(NumaPlacement::Interleaved, -1);
+    }
+
+    [[nodiscard]] NumaPlacement placement() const noexcept { return m_placement; }
+
+    /// @brief The node that holds the memory, or -1 unless it's placed on a chosen node
+    [[nodiscard]] int node() const noexcept { return m_node; }
+
+    /// @brief The length, in bytes, of the mapping that backs an allocation of `n` elements
+    [[nodiscard]] static size_t mapping_length(size_t n) noexcept
+    {
+        const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return (n * sizeof(T) + page - 1) / page * page;
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        if (n > (std::numeric_limits<std::size_t>::max() - page) / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        if (n == 0)
+        {
+            return nullptr;
+        }
+
+        const auto length = mapping_length(n);
+        void* p = nullptr;
+        switch (m_placement)
+        {
+            case NumaPlacement::Local:
+                p = numa_alloc_local(length);
+                break;
+            case NumaPlacement::Node:
+                p = numa_alloc_onnode(length, m_node);
+                break;
+            case NumaPlacement::Interleaved:
+                p = numa_alloc_interleaved(length);
+                break;
+        }
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (p != nullptr)
+        {
+            numa_free(p, mapping_length(n));
+        }
+    }
+
+    /// @brief The capacity of a block allocated for `n` elements, up to the end of its last page
+    [[nodiscard]] std::size_t usable_capacity(T* /*p*/, std::size_t n) const noexcept
+    {
+        return mapping_length(n) / sizeof(T);
+    }
+
+    template<class U>
+    constexpr bool operator==(const NumaAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+
+    template<class U>
+    constexpr bool operator!=(const NumaAllocator<U>&) const noexcept
+    {
+        return false;
+    }
+};
+
+/// @brief The NUMA node holding the page at `p`, which must have been touched, or -1 on error
+[[nodiscard]] inline int numa_node_of(const void* p) noexcept
+{
+    int node = -1;
+    if (get_mempolicy(&node, nullptr, 0, const_cast<void*>(p), MPOL_F_NODE | MPOL_F_ADDR) != 0)
+    {
+        return -1;
+    }
+    return node;
+}
+
+/// @brief Migrate the pages of a leaked vector to `node`, e.g., where its consumer will run
+///
+/// The whole block is bound to `node` first, with `mbind()`, so the pages that were never touched
+/// are allocated there when they're first touched; then the touched pages are migrated. The
+/// allocator in the parts is updated to place memory on `node`.
+///
+/// @return the number of touched pages that are on `node` after the migration
+/// @throws std::system_error if `mbind()` or `move_pages()` fails, e.g., because the node doesn't
+/// exist
+template<typename T>
+size_t move_to_node(std::tuple<T*, size_t, size_t, NumaAllocator<T>>& parts, int node)
+{
+    auto& [data, size, capacity, alloc] = parts;
+    static_cast<void>(size);
+    if (data == nullptr)
+    {
+        alloc = NumaAllocator<T>::on_node(node);
+        return 0;
+    }
+
+    const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const auto length = alloc.mapping_length(capacity);
+    auto* first_page = reinterpret_cast<char*>(data);
+
+    // Like numa_alloc_onnode(), bind the mapping to the node, which only applies to new pages
+    constexpr size_t word_bits = std::numeric_limits<unsigned long>::digits;
+    const auto possible_nodes = static_cast<size_t>(numa_num_possible_nodes());
+    if (node < 0 || static_cast<size_t>(node) >= possible_nodes)
+    {
+        throw std::system_error(EINVAL, std::generic_category(), "mbind");
+    }
+    auto mask = std::vector<unsigned long>((possible_nodes + word_bits - 1) / word_bits);
+    mask[static_cast<size_t>(node) / word_bits] |= 1UL << (static_cast<size_t>(node) % word_bits);
+    // The kernel reads one less bit than maxnode
+    if (mbind(first_page, length, MPOL_BIND, mask.data(), mask.size() * word_bits + 1, 0) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "mbind");
+    }
+
+    // Migrate a chunk of pages at a time, so that the arrays for move_pages() fit on the stack
+    constexpr size_t chunk_pages = 256;
+    void* pages[chunk_pages];
+    int nodes[chunk_pages];
+    int status[chunk_pages];
+
+    const auto page_count = length / page;
+    size_t moved = 0;
+    for (size_t chunk = 0; chunk < page_count; chunk += chunk_pages)
+    {
+        const auto count = page_count - chunk < chunk_pages ? page_count - chunk : chunk_pages;
+        for (size_t i = 0; i < count; i++)
+        {
+            pages[i] = first_page + (chunk + i) * page;
+            nodes[i] = node;
+        }
+        if (move_pages(0, count, pages, nodes, status, MPOL_MF_MOVE) < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "move_pages");
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            // A page that was never touched has a negative status, like one that failed to move
+            moved += status[i] == node ? 1 : 0;
+        }
+    }
+
+    alloc = NumaAllocator<T>::on_node(node);
+    return moved;
+}
+}  // namespace leaky
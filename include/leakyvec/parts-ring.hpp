@@ -0,0 +1,199 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace leaky {
+namespace detail {
+    // std::hardware_destructive_interference_size isn't ABI-stable, so GCC warns about using it
+    // in headers
+    constexpr size_t cache_line_size = 64;
+}  // namespace detail
+
+/// @brief A bounded lock-free multi-producer multi-consumer ring buffer of leaked vectors' parts
+///
+/// This hands the parts returned by `Vec::leak()`, allocator included, from producer threads to
+/// consumer threads. Each slot has a sequence number that tells producers and consumers whose turn
+/// it is (Dmitry Vyukov's bounded MPMC queue), so a push or pop writes two cache lines in the
+/// uncontended case: the claimed position, and the slot. The batch methods claim many consecutive
+/// slots at once, with a single compare-and-swap.
+///
+/// Parts still in the ring when it's destroyed are reconstructed into vectors and destroyed, so
+/// they're freed with their allocators.
+///
+/// @tparam T the element type
+/// @tparam Alloc the allocator type
+template<typename T, typename Alloc = typename std::vector<T>::allocator_type>
+class PartsRing
+{
+  public:
+    using pointer = typename std::vector<T, Alloc>::pointer;
+    using parts_type = std::tuple<pointer, size_t, size_t, Alloc>;
+
+  private:
+    struct alignas(detail::cache_line_size) Slot
+    {
+        std::atomic<size_t> sequence;
+        alignas(parts_type) unsigned char storage[sizeof(parts_type)];
+
+        parts_type& parts() noexcept
+        {
+            return *std::launder(reinterpret_cast<parts_type*>(storage));
+        }
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask;
+    alignas(detail::cache_line_size) std::atomic<size_t> m_push_pos{0};
+    alignas(detail::cache_line_size) std::atomic<size_t> m_pop_pos{0};
+
+    static size_t round_up_pow2(size_t n) noexcept
+    {
+        size_t pow2 = 1;
+        while (pow2 < n)
+        {
+            pow2 <<= 1;
+        }
+        return pow2;
+    }
+
+    size_t sequence(size_t pos) const noexcept
+    {
+        return m_slots[pos & m_mask].sequence.load(std::memory_order_acquire);
+    }
+
+    static intptr_t distance(size_t sequence, size_t pos) noexcept
+    {
+        return static_cast<intptr_t>(sequence - pos);
+    }
+
+    /// @brief Claim up to `n` consecutive slots whose sequence number is `pos + offset`
+    ///
+    /// Producers claim slots with an offset of 0, and consumers with an offset of 1.
+    ///
+    /// @return the first claimed position, and the number of claimed slots
+    std::pair<size_t, size_t> claim(std::atomic<size_t>& cursor, size_t offset, size_t n) noexcept
+    {
+        size_t pos = cursor.load(std::memory_order_relaxed);
+        while (true)
+        {
+            size_t count = 0;
+            while (count < n && distance(sequence(pos + count), pos + count + offset) == 0)
+            {
+                count++;
+            }
+
+            if (count == 0)
+            {
+                if (distance(sequence(pos), pos + offset) < 0)
+                {
+                    // The ring is full for producers, or empty for consumers
+                    return {pos, 0};
+                }
+                // Another thread claimed the slot since we loaded the cursor
+                pos = cursor.load(std::memory_order_relaxed);
+            }
+            else if (cursor.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+            {
+                return {pos, count};
+            }
+        }
+    }
+
+  public:
+    /// @brief Create a ring that holds at least `capacity` parts
+    ///
+    /// The capacity is rounded up to a power of two.
+    ///
+    /// @throws std::bad_alloc if the slots can't be allocated
+    explicit PartsRing(size_t capacity)
+        : m_slots(std::make_unique<Slot[]>(round_up_pow2(capacity == 0 ? 1 : capacity))),
+          m_mask(round_up_pow2(capacity == 0 ? 1 : capacity) - 1)
+    {
+        for (size_t i = 0; i <= m_mask; i++)
+        {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    PartsRing(const PartsRing&) = delete;
+    PartsRing& operator=(const PartsRing&) = delete;
+
+    ~PartsRing() noexcept
+    {
+        while (auto parts = try_pop())
+        {
+            static_cast<void>(Vec<T, Alloc>::from_parts(std::move(*parts)).take());
+        }
+    }
+
+    [[nodiscard]] size_t capacity() const noexcept { return m_mask + 1; }
+
+    /// @brief Push parts into the ring, unless it's full
+    ///
+    /// @return whether the parts were moved into the ring
+    bool try_push(parts_type&& parts) noexcept
+    {
+        return try_push_n(std::make_move_iterator(&parts), 1) == 1;
+    }
+
+    /// @brief Push up to `n` parts into the ring, stopping early if it fills up
+    ///
+    /// @param first an iterator to the parts to push. The pushed parts are moved from.
+    /// @return the number of parts pushed, i.e., moved into the ring
+    template<typename InputIt>
+    size_t try_push_n(InputIt first, size_t n) noexcept
+    {
+        const auto [pos, count] = claim(m_push_pos, 0, n);
+        for (size_t i = 0; i < count; i++, ++first)
+        {
+            auto& slot = m_slots[(pos + i) & m_mask];
+            ::new (static_cast<void*>(slot.storage)) parts_type(std::move(*first));
+            slot.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /// @brief Pop parts from the ring, unless it's empty
+    [[nodiscard]] std::optional<parts_type> try_pop() noexcept
+    {
+        const auto [pos, count] = claim(m_pop_pos, 1, 1);
+        if (count == 0)
+        {
+            return std::nullopt;
+        }
+        auto& slot = m_slots[pos & m_mask];
+        auto parts = std::optional<parts_type>(std::move(slot.parts()));
+        slot.parts().~parts_type();
+        slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return parts;
+    }
+
+    /// @brief Pop up to `n` parts from the ring, stopping early if it empties
+    ///
+    /// @param out an output iterator that the popped parts are moved to. Assigning through it must
+    ///            not throw, so reserve space up front when it's a back inserter.
+    /// @return the number of parts popped
+    template<typename OutputIt>
+    size_t try_pop_n(OutputIt out, size_t n) noexcept
+    {
+        const auto [pos, count] = claim(m_pop_pos, 1, n);
+        for (size_t i = 0; i < count; i++, ++out)
+        {
+            auto& slot = m_slots[(pos + i) & m_mask];
+            *out = std::move(slot.parts());
+            slot.parts().~parts_type();
+            slot.sequence.store(pos + i + m_mask + 1, std::memory_order_release);
+        }
+        return count;
+    }
+};
+}  // namespace leaky
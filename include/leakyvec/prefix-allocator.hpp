@@ -0,0 +1,157 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+
+namespace leaky {
+
+/// @brief An allocator adaptor that reserves `PrefixBytes` bytes right in front of every block
+///
+/// The reserved bytes are hidden from the vector: its `data()` starts right after them. They're
+/// meant for a wire header, so that `leak_with_prefix()` can hand out the header and the elements
+/// as a single contiguous frame, sent with one `send()` or `write()` instead of copying the
+/// elements or adding an iovec. Unlike hiding the prefix in a plain vector's block, the adaptor
+/// knows where its blocks start, so the vector can still grow, and `deallocate()` gives the whole
+/// block back to the underlying allocator.
+///
+/// The prefix is rounded up to a whole number of elements, and the padding goes in front of the
+/// header, so the header always ends exactly where the elements start.
+///
+/// @tparam T the element type
+/// @tparam PrefixBytes the size of the reserved header in bytes
+/// @tparam Base the allocator that allocates the whole blocks, e.g., `MallocAllocator<T>`
+template<typename T, size_t PrefixBytes, typename Base = std::allocator<T>>
+class PrefixAllocator
+{
+  private:
+    using BaseTraits = std::allocator_traits<Base>;
+    static_assert(std::is_same_v<typename BaseTraits::value_type, T>,
+                  "The base allocator must allocate T");
+
+    Base m_base;
+
+    template<typename, size_t, typename>
+    friend class PrefixAllocator;
+
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment =
+        typename BaseTraits::propagate_on_container_copy_assignment;
+    using propagate_on_container_move_assignment =
+        typename BaseTraits::propagate_on_container_move_assignment;
+    using propagate_on_container_swap = typename BaseTraits::propagate_on_container_swap;
+    using is_always_equal = typename BaseTraits::is_always_equal;
+
+    static constexpr size_t prefix_bytes = PrefixBytes;
+    /// The number of elements reserved in front of every block, to hold the prefix
+    static constexpr size_t prefix_elements = (PrefixBytes + sizeof(T) - 1) / sizeof(T);
+
+    // allocator_traits can't rebind an allocator with a non-type template parameter
+    template<typename U>
+    struct rebind
+    {
+        using other =
+            PrefixAllocator<U, PrefixBytes, typename BaseTraits::template rebind_alloc<U>>;
+    };
+
+    PrefixAllocator() noexcept(noexcept(Base())) = default;
+    explicit PrefixAllocator(const Base& base) noexcept : m_base(base) {}
+    template<typename U, typename OtherBase>
+    PrefixAllocator(const PrefixAllocator<U, PrefixBytes, OtherBase>& other) noexcept :
+        m_base(other.m_base)
+    {
+    }
+
+    [[nodiscard]] const Base& base() const noexcept { return m_base; }
+
+    /// @brief The prefix in front of a block's elements
+    [[nodiscard]] static uint8_t* prefix(T* data) noexcept
+    {
+        return reinterpret_cast<uint8_t*>(data) - PrefixBytes;
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T) - prefix_elements)
+        {
+            throw std::bad_array_new_length();
+        }
+        return BaseTraits::allocate(m_base, n + prefix_elements) + prefix_elements;
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        BaseTraits::deallocate(m_base, p - prefix_elements, n + prefix_elements);
+    }
+
+    /// @brief Select the allocator of a vector's copy, like the base allocator does
+    [[nodiscard]] PrefixAllocator select_on_container_copy_construction() const
+    {
+        return PrefixAllocator(BaseTraits::select_on_container_copy_construction(m_base));
+    }
+
+    template<typename U, typename OtherBase>
+    bool operator==(const PrefixAllocator<U, PrefixBytes, OtherBase>& other) const noexcept
+    {
+        return m_base == other.m_base;
+    }
+
+    template<typename U, typename OtherBase>
+    bool operator!=(const PrefixAllocator<U, PrefixBytes, OtherBase>& other) const noexcept
+    {
+        return !(*this == other);
+    }
+};
+
+/// @brief A leaked vector with a prefix, and the frame made of the prefix and its elements
+template<typename T, size_t PrefixBytes, typename Base>
+struct PrefixedParts
+{
+    using allocator_type = PrefixAllocator<T, PrefixBytes, Base>;
+
+    /// The raw parts, which `Vec::from_parts()` reconstructs as usual
+    std::tuple<T*, size_t, size_t, allocator_type> parts;
+    /// The start of the frame, i.e., of the prefix
+    uint8_t* frame;
+    /// The size of the frame in bytes: the prefix, followed by the elements
+    size_t frame_size;
+
+    /// @brief The prefix, for writing the header into
+    [[nodiscard]] uint8_t* header() const noexcept { return frame; }
+};
+
+/// @brief Leak a vector whose allocator reserves a prefix, and get its header and elements as a
+/// single contiguous frame
+///
+/// Write the header into `header()`, send the whole frame in one call, and reconstruct the vector
+/// from `parts` with `Vec::from_parts()` when the frame's memory can be reused or freed.
+///
+/// @note After calling this function, the leaky Vec is left in an empty state.
+/// @throws std::bad_alloc if the vector never allocated, and allocating a block for the header
+/// fails; the vector is left unchanged then
+template<typename T, size_t PrefixBytes, typename Base>
+[[nodiscard]] PrefixedParts<T, PrefixBytes, Base>
+leak_with_prefix(Vec<T, PrefixAllocator<T, PrefixBytes, Base>>& vec)
+{
+    if (vec.as_ref().data() == nullptr)
+    {
+        // Even an empty payload needs a block to hold its header
+        vec.as_mut().reserve(1);
+    }
+
+    auto parts = vec.leak();
+    auto* data = std::get<0>(parts);
+    const auto size = std::get<1>(parts);
+    return PrefixedParts<T, PrefixBytes, Base>{
+        std::move(parts),
+        PrefixAllocator<T, PrefixBytes, Base>::prefix(data),
+        PrefixBytes + size * sizeof(T),
+    };
+}
+}  // namespace leaky
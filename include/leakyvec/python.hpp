@@ -0,0 +1,246 @@
+#pragma once
+#include "leakyvec.hpp"
+
+#include <Python.h>
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+
+#if PY_VERSION_HEX < 0x03090000
+#error "leakyvec/python.hpp requires Python 3.9 or newer"
+#endif
+
+namespace leaky {
+namespace detail {
+    /// @brief The struct module format character of a primitive type, or '\0' if it has none
+    template<typename T>
+    constexpr char buffer_format() noexcept
+    {
+        if constexpr (std::is_same_v<T, float>)
+        {
+            return 'f';
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            return 'd';
+        }
+        else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+        {
+            // Match the integer's width with the (usual) native sizes of b, h, i, and q
+            constexpr char signed_formats[] = {'b', 'h', '\0', 'i', '\0', '\0', '\0', 'q'};
+            constexpr char unsigned_formats[] = {'B', 'H', '\0', 'I', '\0', '\0', '\0', 'Q'};
+            return std::is_signed_v<T> ? signed_formats[sizeof(T) - 1]
+                                       : unsigned_formats[sizeof(T) - 1];
+        }
+        else
+        {
+            return '\0';
+        }
+    }
+
+    /// @brief The kind character of a primitive type in a NumPy array interface typestr
+    template<typename T>
+    constexpr char array_interface_kind() noexcept
+    {
+        return std::is_floating_point_v<T> ? 'f' : std::is_signed_v<T> ? 'i' : 'u';
+    }
+
+    constexpr const char* capsule_name = "leakyvec.parts";
+
+    template<typename T, typename Alloc>
+    using PyParts = std::tuple<typename std::vector<T, Alloc>::pointer, size_t, size_t, Alloc>;
+
+    template<typename T, typename Alloc>
+    void destroy_capsule(PyObject* capsule) noexcept
+    {
+        auto parts = std::unique_ptr<PyParts<T, Alloc>>(
+            static_cast<PyParts<T, Alloc>*>(PyCapsule_GetPointer(capsule, capsule_name)));
+        if (parts == nullptr)
+        {
+            // The capsule was renamed, so its pointer may not be ours; leaking beats freeing it.
+            // Report the error without the capsule, which would be resurrected mid-destruction.
+            PyErr_WriteUnraisable(nullptr);
+            return;
+        }
+        static_cast<void>(Vec<T, Alloc>::from_parts(std::move(*parts)).take());
+    }
+
+    /// @brief A Python object exposing a leaked vector through the buffer protocol
+    ///
+    /// The element type is erased, so a single Python type serves vectors of any `T`. The object
+    /// keeps the capsule that owns the vector alive.
+    struct PyLeakedBuffer
+    {
+        PyObject_HEAD
+        PyObject* capsule;
+        void* data;
+        Py_ssize_t shape[1];
+        Py_ssize_t strides[1];
+        char format[2];
+        char typestr[8];
+    };
+
+    inline void leaked_buffer_dealloc(PyObject* self) noexcept
+    {
+        auto* type = Py_TYPE(self);
+        Py_XDECREF(reinterpret_cast<PyLeakedBuffer*>(self)->capsule);
+        type->tp_free(self);
+        Py_DECREF(type);
+    }
+
+    inline int leaked_buffer_getbuffer(PyObject* self, Py_buffer* view, int flags) noexcept
+    {
+        auto* buffer = reinterpret_cast<PyLeakedBuffer*>(self);
+        Py_INCREF(self);
+        view->obj = self;
+        view->buf = buffer->data;
+        view->len = buffer->shape[0] * buffer->strides[0];
+        view->readonly = 0;
+        view->itemsize = buffer->strides[0];
+        view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? buffer->format : nullptr;
+        view->ndim = 1;
+        view->shape = (flags & PyBUF_ND) == PyBUF_ND ? buffer->shape : nullptr;
+        view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? buffer->strides : nullptr;
+        view->suboffsets = nullptr;
+        view->internal = nullptr;
+        return 0;
+    }
+
+    inline PyObject* leaked_buffer_array_interface(PyObject* self, void*) noexcept
+    {
+        auto* buffer = reinterpret_cast<PyLeakedBuffer*>(self);
+        return Py_BuildValue("{s:(n),s:s,s:(NO),s:i}",
+                             "shape",
+                             buffer->shape[0],
+                             "typestr",
+                             buffer->typestr,
+                             "data",
+                             PyLong_FromVoidPtr(buffer->data),
+                             Py_False,
+                             "version",
+                             3);
+    }
+
+    /// @brief Get the LeakedBuffer Python type, creating it on first use
+    ///
+    /// @note The type is created once per process, so it can't be shared between subinterpreters.
+    inline PyTypeObject* leaked_buffer_type() noexcept
+    {
+        static PyGetSetDef getset[] = {
+            {"__array_interface__", &leaked_buffer_array_interface, nullptr, nullptr, nullptr},
+            {nullptr, nullptr, nullptr, nullptr, nullptr},
+        };
+        static PyType_Slot slots[] = {
+            {Py_tp_dealloc, reinterpret_cast<void*>(&leaked_buffer_dealloc)},
+            {Py_tp_getset, static_cast<void*>(getset)},
+            {Py_bf_getbuffer, reinterpret_cast<void*>(&leaked_buffer_getbuffer)},
+            {Py_tp_doc, const_cast<char*>("A vector leaked from C++")},
+            {0, nullptr},
+        };
+        static PyType_Spec spec = {
+            "leakyvec.LeakedBuffer",
+            sizeof(PyLeakedBuffer),
+            0,
+            Py_TPFLAGS_DEFAULT,
+            slots,
+        };
+        static auto* type = reinterpret_cast<PyTypeObject*>(PyType_FromSpec(&spec));
+        return type;
+    }
+}  // namespace detail
+
+/// @brief Whether a vector of `T` can be exported to Python
+template<typename T>
+inline constexpr bool is_python_primitive_v = detail::buffer_format<T>() != '\0';
+
+/// @brief Leak a vector into a PyCapsule that owns its raw parts
+///
+/// The capsule is named "leakyvec.parts", and points to the tuple returned by `leak()`. When the
+/// capsule is destroyed, the vector is reconstructed with `from_parts()` and destroyed, which
+/// frees the data block with the vector's own allocator.
+///
+/// @note The GIL must be held.
+/// @note After calling this function, the vector is left in an empty state.
+///
+/// @return a new reference, or nullptr with a Python exception set, in which case the vector is
+///         left unchanged.
+template<typename T, typename Alloc>
+[[nodiscard]] PyObject* leak_to_capsule(Vec<T, Alloc>& vec) noexcept
+{
+    // The parts are allocated before the vector is leaked, so failing leaves it unchanged
+    auto parts = std::unique_ptr<detail::PyParts<T, Alloc>>(
+        new (std::nothrow) detail::PyParts<T, Alloc>(vec.leak()));
+    if (parts == nullptr)
+    {
+        return PyErr_NoMemory();
+    }
+
+    auto* capsule =
+        PyCapsule_New(parts.get(), detail::capsule_name, &detail::destroy_capsule<T, Alloc>);
+    if (capsule == nullptr)
+    {
+        vec = Vec<T, Alloc>::from_parts(std::move(*parts));
+        return nullptr;
+    }
+    static_cast<void>(parts.release());
+    return capsule;
+}
+
+/// @brief Leak a vector into a Python object that exposes its elements without copying them
+///
+/// The object implements the buffer protocol, so `memoryview(obj)` and `numpy.asarray(obj)` borrow
+/// the vector's data block, and keep the object alive. It also has an `__array_interface__` for
+/// consumers that only support NumPy's protocol. The elements are writable.
+///
+/// @note The GIL must be held.
+/// @note After calling this function, the vector is left in an empty state.
+///
+/// @return a new reference, or nullptr with a Python exception set, in which case the vector is
+///         left unchanged.
+template<typename T, typename Alloc>
+[[nodiscard]] PyObject* leak_to_python(Vec<T, Alloc>& vec) noexcept
+{
+    static_assert(is_python_primitive_v<T>,
+                  "Only vectors of integers, float, or double can be exported to Python");
+
+    auto* type = detail::leaked_buffer_type();
+    if (type == nullptr)
+    {
+        if (PyErr_Occurred() == nullptr)
+        {
+            PyErr_SetString(PyExc_RuntimeError, "failed to create the leakyvec.LeakedBuffer type");
+        }
+        return nullptr;
+    }
+    auto* self = reinterpret_cast<detail::PyLeakedBuffer*>(type->tp_alloc(type, 0));
+    if (self == nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto* data = vec.as_ref().data();
+    const auto size = vec.as_ref().size();
+    self->capsule = leak_to_capsule(vec);
+    if (self->capsule == nullptr)
+    {
+        Py_DECREF(self);
+        return nullptr;
+    }
+
+    self->data = const_cast<void*>(static_cast<const void*>(data));
+    self->shape[0] = static_cast<Py_ssize_t>(size);
+    self->strides[0] = static_cast<Py_ssize_t>(sizeof(T));
+    self->format[0] = detail::buffer_format<T>();
+    self->format[1] = '\0';
+    PyOS_snprintf(self->typestr,
+                  sizeof(self->typestr),
+                  "%c%c%zu",
+                  sizeof(T) == 1 ? '|' : PY_LITTLE_ENDIAN ? '<' : '>',
+                  detail::array_interface_kind<T>(),
+                  sizeof(T));
+    return reinterpret_cast<PyObject*>(self);
+}
+}  // namespace leaky
@@ -0,0 +1,442 @@
+//! Zero-copy ownership transfer between C++ `std::vector`s and Rust `Vec`s.
+//!
+//! The C++ side leaks a vector with `leaky::Vec<T>::leak_to_c()`, which produces a
+//! `leaky_raw_parts` struct (see `include/leakyvec/ffi.h`). That struct has the same layout as
+//! [`RawParts`], so it can be passed across an `extern "C"` boundary by value, and rebuilt into a
+//! `Vec<T>` with [`RawParts::into_vec`] without copying the elements.
+//!
+//! The reverse handoff works the same way: [`RawParts::from_vec`] leaks a `Vec<T>` and the C++ side
+//! rebuilds it with `leaky::Vec<T>::from_c()`, or with `from_foreign()` and [`dealloc_vec`] to free
+//! it with Rust's allocator no matter which allocator C++ uses.
+//!
+//! # Allocators
+//!
+//! Whoever ends up owning the memory block frees it with _their_ allocator. That's only sound if
+//! the two allocators are compatible. Rust's default global allocator (`std::alloc::System`) uses
+//! `malloc` and `free`. A C++ `std::allocator` uses `operator new`, which libstdc++ and libc++
+//! happen to implement with `malloc`, but that isn't guaranteed, and sanitizers will flag the
+//! mismatch. Use `leaky::MallocAllocator<T>` (see `include/leakyvec/malloc-allocator.hpp`) on the
+//! C++ side to guarantee compatibility with `System`.
+//!
+//! If the Rust program installs a different `#[global_allocator]`, neither direction is sound.
+//!
+//! A `Vec<T>` must be freed with exactly `T`'s alignment, so parts whose block is aligned to more
+//! than `align_of::<T>()`, e.g., from `leaky::AlignedAllocator`, can't become a `Vec<T>`. Rebuild
+//! them into an [`AlignedVec`] with [`RawParts::into_aligned_vec`] instead, which frees the block
+//! with its own alignment.
+#![deny(unsafe_op_in_unsafe_fn)]
+
+use std::alloc::{dealloc, Layout};
+use std::mem::{align_of, size_of, ManuallyDrop};
+use std::ops::{Deref, DerefMut};
+use std::ptr::NonNull;
+
+/// The raw parts of a leaked vector, with the same layout as the C `leaky_raw_parts` struct.
+///
+/// An empty, never-allocated C++ vector has a null `ptr`, and zero `len` and `cap`.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct RawParts {
+    /// Pointer to the start of the vector's data block
+    pub ptr: *mut core::ffi::c_void,
+    /// Number of initialized elements
+    pub len: usize,
+    /// Number of allocated elements
+    pub cap: usize,
+    /// `size_of::<T>()` in bytes
+    pub elem_size: usize,
+    /// Alignment of the data block in bytes: `align_of::<T>()`, or larger for over-aligning
+    /// allocators like `leaky::AlignedAllocator`
+    pub align: usize,
+}
+
+// The C++ side uses size_t and void*, which match usize and a raw pointer on every platform Rust
+// supports through the C ABI.
+const _: () = assert!(size_of::<RawParts>() == size_of::<*mut u8>() + 4 * size_of::<usize>());
+const _: () = assert!(align_of::<RawParts>() == align_of::<usize>());
+
+/// Compile-time checks on the element type
+struct ElementLayout<T>(core::marker::PhantomData<T>);
+
+impl<T> ElementLayout<T> {
+    /// C++ has no zero-sized types, so there's no way a `std::vector` could have produced a
+    /// block of them, and `Vec<T>` doesn't allocate for them anyways.
+    const CHECK: () = assert!(
+        size_of::<T>() != 0,
+        "zero-sized types can't cross the C++ ABI"
+    );
+}
+
+impl RawParts {
+    /// The parts of an empty vector that owns no memory
+    pub const fn empty<T>() -> Self {
+        let () = ElementLayout::<T>::CHECK;
+        Self {
+            ptr: core::ptr::null_mut(),
+            len: 0,
+            cap: 0,
+            elem_size: size_of::<T>(),
+            align: align_of::<T>(),
+        }
+    }
+
+    /// Whether these parts were produced for a vector of `T`
+    ///
+    /// The data block may be aligned to more than `align_of::<T>()`, e.g., for SIMD kernels. Only
+    /// parts with exactly `T`'s alignment can become a `Vec<T>`; see [`RawParts::is_over_aligned`].
+    pub const fn is_for<T>(&self) -> bool {
+        let () = ElementLayout::<T>::CHECK;
+        self.elem_size == size_of::<T>()
+            && self.align.is_power_of_two()
+            && self.align >= align_of::<T>()
+    }
+
+    /// Whether the data block is aligned to more than `align_of::<T>()`, so that it must be rebuilt
+    /// with [`RawParts::into_aligned_vec`] rather than [`RawParts::into_vec`]
+    pub const fn is_over_aligned<T>(&self) -> bool {
+        self.align > align_of::<T>()
+    }
+
+    /// Leak a `Vec<T>` into its raw parts, so it can be handed to `leaky::Vec<T>::from_c()`
+    pub fn from_vec<T>(vec: Vec<T>) -> Self {
+        let () = ElementLayout::<T>::CHECK;
+        if vec.capacity() == 0 {
+            // A Vec with no capacity has a dangling pointer, but std::vector expects null
+            return Self::empty::<T>();
+        }
+
+        let mut vec = ManuallyDrop::new(vec);
+        Self {
+            ptr: vec.as_mut_ptr().cast(),
+            len: vec.len(),
+            cap: vec.capacity(),
+            elem_size: size_of::<T>(),
+            align: align_of::<T>(),
+        }
+    }
+
+    /// Rebuild a `Vec<T>` from parts leaked by `leaky::Vec<T>::leak_to_c()`
+    ///
+    /// # Panics
+    ///
+    /// Panics if the parts were not produced for an element type with the same size and alignment
+    /// as `T`, if the block is over-aligned, or if the length exceeds the capacity.
+    ///
+    /// # Safety
+    ///
+    /// * The parts must have been produced by `leak_to_c()` (or [`RawParts::from_vec`]), and must
+    ///   not be reconstructed more than once.
+    /// * The first `len` elements must be initialized, valid values of `T`.
+    /// * The memory block must be deallocatable by Rust's global allocator with a layout of
+    ///   `cap` elements of `T`. See the crate-level docs on allocator compatibility.
+    pub unsafe fn into_vec<T>(self) -> Vec<T> {
+        let () = ElementLayout::<T>::CHECK;
+        assert!(self.is_for::<T>(), "element type mismatch: {self:?}");
+        // Vec<T> frees its block with align_of::<T>(), which must match how it was allocated
+        assert!(
+            !self.is_over_aligned::<T>(),
+            "over-aligned block, use into_aligned_vec: {self:?}"
+        );
+        assert!(self.len <= self.cap, "length exceeds capacity: {self:?}");
+
+        if self.ptr.is_null() {
+            assert_eq!(self.cap, 0, "null pointer with non-zero capacity: {self:?}");
+            return Vec::new();
+        }
+
+        // SAFETY: The caller guarantees that the parts describe a live allocation of cap elements
+        // of T, len of which are initialized, and that's compatible with the global allocator.
+        unsafe { Vec::from_raw_parts(self.ptr.cast::<T>(), self.len, self.cap) }
+    }
+
+    /// Rebuild an [`AlignedVec<T>`] from parts leaked by `leaky::Vec<T>::leak_to_c()`, whatever
+    /// the block's alignment
+    ///
+    /// # Panics
+    ///
+    /// Panics if the parts were not produced for an element type with the same size as `T`, and
+    /// an alignment at least as large, or if the length exceeds the capacity.
+    ///
+    /// # Safety
+    ///
+    /// * The parts must have been produced by `leak_to_c()`, and must not be reconstructed more
+    ///   than once.
+    /// * The first `len` elements must be initialized, valid values of `T`.
+    /// * The memory block must be deallocatable by Rust's global allocator with the layout
+    ///   described by [`AlignedVec::layout`], like the blocks of `leaky::AlignedAllocator`, which
+    ///   are padded to a multiple of their alignment.
+    pub unsafe fn into_aligned_vec<T>(self) -> AlignedVec<T> {
+        let () = ElementLayout::<T>::CHECK;
+        assert!(self.is_for::<T>(), "element type mismatch: {self:?}");
+        assert!(self.len <= self.cap, "length exceeds capacity: {self:?}");
+        let ptr = match NonNull::new(self.ptr.cast::<T>()) {
+            Some(ptr) => ptr,
+            None => {
+                assert_eq!(self.cap, 0, "null pointer with non-zero capacity: {self:?}");
+                NonNull::dangling()
+            }
+        };
+        AlignedVec {
+            ptr,
+            len: self.len,
+            cap: self.cap,
+            align: self.align,
+        }
+    }
+}
+
+/// An owned block of `T`s from C++ that's aligned to more than `align_of::<T>()`
+///
+/// This derefs to a slice of the initialized elements, and frees the block with its own alignment
+/// when dropped, which a `Vec<T>` can't do.
+pub struct AlignedVec<T> {
+    ptr: NonNull<T>,
+    len: usize,
+    cap: usize,
+    align: usize,
+}
+
+// SAFETY: AlignedVec owns its elements, like Vec<T>
+unsafe impl<T: Send> Send for AlignedVec<T> {}
+// SAFETY: AlignedVec only hands out shared references through &self, like Vec<T>
+unsafe impl<T: Sync> Sync for AlignedVec<T> {}
+
+impl<T> AlignedVec<T> {
+    /// The number of allocated elements
+    pub fn capacity(&self) -> usize {
+        self.cap
+    }
+
+    /// The alignment of the block in bytes
+    pub fn alignment(&self) -> usize {
+        self.align
+    }
+
+    /// The layout the block is freed with: `cap` elements of `T`, padded to a multiple of the
+    /// alignment, as allocated by `leaky::AlignedAllocator`, or `None` if there's no block
+    pub fn layout(&self) -> Option<Layout> {
+        if self.cap == 0 {
+            return None;
+        }
+        let bytes = (self.cap * size_of::<T>()).next_multiple_of(self.align);
+        Some(Layout::from_size_align(bytes, self.align).expect("invalid block layout"))
+    }
+}
+
+impl<T> Deref for AlignedVec<T> {
+    type Target = [T];
+
+    fn deref(&self) -> &[T] {
+        // SAFETY: The first len elements are initialized, and the pointer is non-null and aligned
+        unsafe { core::slice::from_raw_parts(self.ptr.as_ptr(), self.len) }
+    }
+}
+
+impl<T> DerefMut for AlignedVec<T> {
+    fn deref_mut(&mut self) -> &mut [T] {
+        // SAFETY: As above, and self is borrowed mutably
+        unsafe { core::slice::from_raw_parts_mut(self.ptr.as_ptr(), self.len) }
+    }
+}
+
+impl<T> Drop for AlignedVec<T> {
+    fn drop(&mut self) {
+        // SAFETY: The elements are initialized, and dropped only once
+        unsafe { core::ptr::drop_in_place(&mut **self as *mut [T]) };
+        if let Some(layout) = self.layout() {
+            // SAFETY: The caller of into_aligned_vec guaranteed that the block has this layout
+            unsafe { dealloc(self.ptr.as_ptr().cast(), layout) };
+        }
+    }
+}
+
+/// A callback that frees a memory block, with the same signature as the C `leaky_dealloc_fn`
+///
+/// Pass one of these, e.g. [`dealloc_vec`], to `leaky::Vec<T, ForeignAllocator<T>>::from_foreign()`
+/// so that the C++ side frees a Rust `Vec`'s memory with Rust's global allocator.
+pub type DeallocFn =
+    unsafe extern "C" fn(ctx: *mut core::ffi::c_void, ptr: *mut core::ffi::c_void, cap: usize);
+
+/// Free a memory block of `cap` elements of `T` that was allocated by a Rust `Vec<T>`
+///
+/// The `ctx` pointer is unused. The elements are not dropped; by the time C++ frees the block, it
+/// has already destroyed them.
+///
+/// # Safety
+///
+/// `ptr` and `cap` must describe a memory block from a `Vec<T>` leaked by [`RawParts::from_vec`].
+pub unsafe extern "C" fn dealloc_vec<T>(
+    _ctx: *mut core::ffi::c_void,
+    ptr: *mut core::ffi::c_void,
+    cap: usize,
+) {
+    if ptr.is_null() {
+        return;
+    }
+    // SAFETY: The caller guarantees that the block came from a Vec<T> with this capacity
+    drop(unsafe { Vec::from_raw_parts(ptr.cast::<T>(), 0, cap) });
+}
+
+#[cfg(feature = "demo")]
+pub mod demo {
+    //! `extern "C"` functions used to test handing vectors across the language boundary.
+    use super::RawParts;
+
+    /// Take ownership of a C++ `std::vector<uint64_t>`, sum it, and free it in Rust
+    ///
+    /// # Safety
+    ///
+    /// See [`RawParts::into_vec`].
+    #[no_mangle]
+    pub unsafe extern "C" fn leaky_demo_sum_u64(parts: RawParts) -> u64 {
+        // SAFETY: forwarded to the caller
+        let vec = unsafe { parts.into_vec::<u64>() };
+        vec.iter().sum()
+    }
+
+    /// Create the Rust `Vec<u64>` `[0, 1, ..., len)` with the given capacity and leak it to C++
+    #[no_mangle]
+    pub extern "C" fn leaky_demo_iota_u64(len: usize, cap: usize) -> RawParts {
+        let mut vec = Vec::with_capacity(cap.max(len));
+        vec.extend(0..len as u64);
+        RawParts::from_vec(vec)
+    }
+
+    /// Free a `Vec<u64>` leaked by [`leaky_demo_iota_u64`]
+    ///
+    /// # Safety
+    ///
+    /// See [`super::dealloc_vec`].
+    #[no_mangle]
+    pub unsafe extern "C" fn leaky_demo_dealloc_u64(
+        ctx: *mut core::ffi::c_void,
+        ptr: *mut core::ffi::c_void,
+        cap: usize,
+    ) {
+        // SAFETY: forwarded to the caller
+        unsafe { super::dealloc_vec::<u64>(ctx, ptr, cap) }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn layout_matches_c() {
+        assert_eq!(core::mem::offset_of!(RawParts, ptr), 0);
+        assert_eq!(core::mem::offset_of!(RawParts, len), size_of::<usize>());
+        assert_eq!(core::mem::offset_of!(RawParts, cap), 2 * size_of::<usize>());
+        assert_eq!(
+            core::mem::offset_of!(RawParts, elem_size),
+            3 * size_of::<usize>()
+        );
+        assert_eq!(
+            core::mem::offset_of!(RawParts, align),
+            4 * size_of::<usize>()
+        );
+    }
+
+    #[test]
+    fn round_trip() {
+        let mut vec = Vec::<u32>::with_capacity(10);
+        vec.extend([1, 2, 3, 4]);
+        let original_ptr = vec.as_ptr();
+
+        let parts = RawParts::from_vec(vec);
+        assert_eq!(parts.len, 4);
+        assert_eq!(parts.cap, 10);
+        assert_eq!(parts.elem_size, 4);
+        assert_eq!(parts.align, 4);
+
+        let vec = unsafe { parts.into_vec::<u32>() };
+        assert_eq!(vec.as_ptr(), original_ptr);
+        assert_eq!(vec.capacity(), 10);
+        assert_eq!(vec, [1, 2, 3, 4]);
+    }
+
+    #[test]
+    fn empty_is_null() {
+        let parts = RawParts::from_vec(Vec::<u16>::new());
+        assert!(parts.ptr.is_null());
+        assert_eq!(parts, RawParts::empty::<u16>());
+
+        let vec = unsafe { parts.into_vec::<u16>() };
+        assert!(vec.is_empty());
+    }
+
+    #[test]
+    fn dealloc_fn() {
+        let parts = RawParts::from_vec(Vec::<u64>::with_capacity(10));
+        let dealloc: DeallocFn = dealloc_vec::<u64>;
+        unsafe { dealloc(core::ptr::null_mut(), parts.ptr, parts.cap) };
+    }
+
+    #[test]
+    #[should_panic(expected = "element type mismatch")]
+    fn rejects_wrong_element_type() {
+        let parts = RawParts::from_vec(vec![1u32, 2, 3]);
+        // Leaks the vector when the assertion panics, which is fine in a test
+        let _ = unsafe { parts.into_vec::<u64>() };
+    }
+
+    #[test]
+    fn accepts_over_aligned_blocks() {
+        let parts = RawParts {
+            align: 64,
+            ..RawParts::empty::<f32>()
+        };
+        assert!(parts.is_for::<f32>());
+        assert!(!RawParts { align: 2, ..parts }.is_for::<f32>());
+        assert!(!RawParts { align: 48, ..parts }.is_for::<f32>());
+        assert!(parts.is_over_aligned::<f32>());
+    }
+
+    #[test]
+    #[should_panic(expected = "over-aligned block")]
+    fn into_vec_rejects_over_aligned_blocks() {
+        let parts = RawParts {
+            align: 64,
+            ..RawParts::empty::<f32>()
+        };
+        let _ = unsafe { parts.into_vec::<f32>() };
+    }
+
+    #[test]
+    fn aligned_vec_frees_with_its_alignment() {
+        // Allocate a block like leaky::AlignedAllocator<f32, 64> does for 5 elements
+        let layout = Layout::from_size_align(64, 64).unwrap();
+        let ptr = unsafe { std::alloc::alloc(layout) }.cast::<f32>();
+        assert!(!ptr.is_null());
+        for i in 0..3 {
+            unsafe { ptr.add(i).write(i as f32) };
+        }
+        let parts = RawParts {
+            ptr: ptr.cast(),
+            len: 3,
+            cap: 16,
+            elem_size: size_of::<f32>(),
+            align: 64,
+        };
+
+        let mut vec = unsafe { parts.into_aligned_vec::<f32>() };
+        assert_eq!(vec.as_ptr(), ptr);
+        assert_eq!(*vec, [0.0, 1.0, 2.0]);
+        vec[1] = 5.0;
+        assert_eq!(vec[1], 5.0);
+        assert_eq!(vec.capacity(), 16);
+        assert_eq!(vec.alignment(), 64);
+        assert_eq!(vec.layout(), Some(layout));
+    }
+
+    #[test]
+    fn aligned_vec_empty() {
+        let parts = RawParts {
+            align: 32,
+            ..RawParts::empty::<u8>()
+        };
+        let vec = unsafe { parts.into_aligned_vec::<u8>() };
+        assert!(vec.is_empty());
+        assert_eq!(vec.layout(), None);
+    }
+}
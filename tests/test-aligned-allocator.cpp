@@ -0,0 +1,100 @@
+#include <leakyvec/aligned-allocator.hpp>
+#include <leakyvec/leakyvec.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <gmock/gmock.h>
+
+namespace {
+template<typename T>
+bool is_aligned(const T* p, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+struct Triple
+{
+    float xyz[3];
+};
+}  // namespace
+
+/// Test that every block is aligned, for any capacity
+TEST(AlignedAllocatorTests, Alignment)
+{
+    auto vec = std::vector<float, leaky::AlignedAllocator<float, 64>>();
+    for (int i = 0; i < 100; i++)
+    {
+        vec.push_back(static_cast<float>(i));
+        ASSERT_TRUE(is_aligned(vec.data(), 64));
+    }
+
+    auto vec2 = std::vector<uint8_t, leaky::AlignedAllocator<uint8_t, 4096>>(1);
+    ASSERT_TRUE(is_aligned(vec2.data(), 4096));
+}
+
+/// Test that the leaked capacity is padded to a multiple of the alignment
+TEST(AlignedAllocatorTests, LeakPaddedCapacity)
+{
+    using Alloc = leaky::AlignedAllocator<float, 64>;
+    auto vec = std::vector<float, Alloc>{1, 2, 3};
+    ASSERT_EQ(vec.capacity(), 3);
+
+    auto [data, size, capacity, alloc] = leaky::Vec<float, Alloc>(std::move(vec)).leak();
+    ASSERT_EQ(size, 3);
+    ASSERT_EQ(capacity, 16);
+
+    // The vector can grow into the padding without reallocating
+    auto vec2 = leaky::Vec<float, Alloc>::from_parts({data, size, capacity, alloc}).take();
+    ASSERT_EQ(vec2.capacity(), 16);
+    vec2.resize(16, 4.0f);
+    ASSERT_EQ(vec2.data(), data);
+
+    // Element sizes that don't divide the alignment leave a few bytes unused
+    static_assert(leaky::AlignedAllocator<Triple, 64>::padded_capacity(1) == 5);
+    static_assert(leaky::AlignedAllocator<Triple, 64>::padded_capacity(6) == 10);
+    static_assert(leaky::AlignedAllocator<Triple, 64>::padded_capacity(0) == 0);
+}
+
+/// Test that the C ABI parts carry the alignment, and can be freed with free()
+TEST(AlignedAllocatorTests, LeakToC)
+{
+    using Alloc = leaky::AlignedAllocator<double, 32>;
+    auto leaky_vec = leaky::Vec<double, Alloc>(std::vector<double, Alloc>(5, 1.0));
+    const auto parts = leaky_vec.leak_to_c();
+    ASSERT_EQ(parts.len, 5);
+    ASSERT_EQ(parts.cap, 8);
+    ASSERT_EQ(parts.elem_size, sizeof(double));
+    ASSERT_EQ(parts.align, 32);
+    ASSERT_TRUE(is_aligned(parts.ptr, 32));
+
+    auto vec = leaky::Vec<double, Alloc>::from_c(parts).take();
+    ASSERT_EQ(vec.size(), 5);
+    ASSERT_EQ(vec.capacity(), 8);
+
+    const auto parts2 = leaky::Vec<double, Alloc>(std::move(vec)).leak_to_c();
+    std::free(parts2.ptr);
+}
+
+/// Test that the allocator rebinds to other element types with the same alignment
+TEST(AlignedAllocatorTests, Rebind)
+{
+    using Rebound =
+        std::allocator_traits<leaky::AlignedAllocator<float, 64>>::rebind_alloc<uint16_t>;
+    static_assert(std::is_same_v<Rebound, leaky::AlignedAllocator<uint16_t, 64>>);
+    static_assert(std::allocator_traits<Rebound>::is_always_equal::value);
+    ASSERT_EQ(Rebound(leaky::AlignedAllocator<float, 64>()), Rebound());
+}
+
+/// Test that casting a vector's element type keeps the alignment of its allocator
+TEST(AlignedAllocatorTests, CastInto)
+{
+    using Alloc = leaky::AlignedAllocator<float, 64>;
+    auto leaky_vec = leaky::Vec<float, Alloc>(std::vector<float, Alloc>(16, 1.0f));
+    auto words = leaky_vec.cast_into<uint32_t>();
+    ASSERT_TRUE(words);
+    using Words = std::vector<uint32_t, leaky::AlignedAllocator<uint32_t, 64>>;
+    static_assert(std::is_same_v<decltype(words->take()), Words>);
+    ASSERT_EQ(words->as_ref().size(), 16);
+    ASSERT_EQ(words->as_ref()[0], 0x3f800000);
+}
@@ -0,0 +1,102 @@
+#include <leakyvec/arena-allocator.hpp>
+#include <leakyvec/leakyvec.hpp>
+
+#include <cstdint>
+#include <memory_resource>
+
+#include <gmock/gmock.h>
+
+namespace {
+using ArenaVec = std::vector<int, leaky::ArenaAllocator<int>>;
+
+/// An upstream resource for arenas, that counts the bytes they haven't given back
+struct CountingResource : std::pmr::memory_resource
+{
+    size_t outstanding = 0;
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        outstanding += bytes;
+        return p;
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+}  // namespace
+
+/// The arena allocator is stored in the std::vector as a single pointer
+TEST(ArenaAllocatorTests, MemoryLayout)
+{
+    leaky::Arena arena;
+    auto v = ArenaVec({1, 2, 3, 4}, leaky::ArenaAllocator<int>(arena));
+    v.reserve(10);
+
+    auto wrapper = leaky::detail::VecWrapper<int, leaky::ArenaAllocator<int>>{std::move(v)};
+    ASSERT_EQ(sizeof(leaky::ArenaAllocator<int>), sizeof(void*));
+#if defined(LEAKY_STDLIB_LIBSTDCXX)
+    ASSERT_EQ(wrapper.get_data_ptr_offset(), 1);
+#endif
+    ASSERT_EQ(*wrapper.get_data_start_ptr(), wrapper.inner.data());
+    ASSERT_EQ(*wrapper.get_data_end_ptr(), wrapper.inner.data() + 4);
+    ASSERT_EQ(*wrapper.get_capacity_end_ptr(), wrapper.inner.data() + 10);
+}
+
+/// The allocator part of the leaked vector is a handle to the arena
+TEST(ArenaAllocatorTests, LeakReturnsArena)
+{
+    leaky::Arena arena;
+    auto v = ArenaVec({1, 2, 3, 4}, leaky::ArenaAllocator<int>(arena));
+    const auto* original_data = v.data();
+
+    auto leaky_v = leaky::Vec<int, leaky::ArenaAllocator<int>>(std::move(v));
+    auto parts = leaky_v.leak();
+    auto [data, size, capacity, alloc] = parts;
+    ASSERT_EQ(data, original_data);
+    ASSERT_EQ(size, 4);
+    ASSERT_EQ(&alloc.arena(), &arena);
+
+    auto v2 = leaky::Vec<int, leaky::ArenaAllocator<int>>::from_parts(parts).take();
+    ASSERT_EQ(v2.data(), original_data);
+    ASSERT_EQ(v2.get_allocator(), leaky::ArenaAllocator<int>(arena));
+}
+
+/// Leaked vectors don't need to be reconstructed or deallocated; releasing the arena frees them
+TEST(ArenaAllocatorTests, ReleaseFreesEverything)
+{
+    auto upstream = CountingResource();
+    leaky::Arena arena(&upstream);
+    for (int round = 0; round < 3; round++)
+    {
+        for (int i = 0; i < 100; i++)
+        {
+            auto v = ArenaVec(static_cast<size_t>(i), round, leaky::ArenaAllocator<int>(arena));
+            auto leaky_v = leaky::Vec<int, leaky::ArenaAllocator<int>>(std::move(v));
+            static_cast<void>(leaky_v.leak());
+        }
+        ASSERT_GT(upstream.outstanding, 0);
+        arena.release();
+        ASSERT_EQ(upstream.outstanding, 0);
+    }
+}
+
+/// Allocators for different element types can share the same arena
+TEST(ArenaAllocatorTests, Rebind)
+{
+    leaky::Arena arena;
+    const auto int_alloc = leaky::ArenaAllocator<int>(arena);
+    const auto byte_alloc = leaky::ArenaAllocator<uint8_t>(int_alloc);
+    ASSERT_EQ(&byte_alloc.arena(), &arena);
+    ASSERT_TRUE(int_alloc == byte_alloc);
+
+    leaky::Arena other_arena;
+    ASSERT_TRUE(int_alloc != leaky::ArenaAllocator<int>(other_arena));
+}
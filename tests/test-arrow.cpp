@@ -0,0 +1,129 @@
+#include "mock-allocator.hpp"
+
+#include <leakyvec/arrow.hpp>
+
+#include <cstring>
+
+#include <gmock/gmock.h>
+
+/// Test that a vector is exported as an Arrow primitive array that borrows its data block
+TEST(ArrowTests, LeakToArrow)
+{
+    auto leaky_vec = leaky::Vec<int32_t>(std::vector<int32_t>{1, 2, 3});
+    const auto* data = leaky_vec.as_ref().data();
+
+    ArrowArray array;
+    ArrowSchema schema;
+    leaky::leak_to_arrow(leaky_vec, &array, &schema);
+    ASSERT_TRUE(leaky_vec.as_ref().empty());
+    ASSERT_EQ(leaky_vec.as_ref().capacity(), 0);
+
+    ASSERT_STREQ(schema.format, "i");
+    ASSERT_EQ(schema.name, nullptr);
+    ASSERT_EQ(schema.flags, 0);
+    ASSERT_EQ(schema.n_children, 0);
+    ASSERT_NE(schema.release, nullptr);
+
+    ASSERT_EQ(array.length, 3);
+    ASSERT_EQ(array.null_count, 0);
+    ASSERT_EQ(array.offset, 0);
+    ASSERT_EQ(array.n_buffers, 2);
+    ASSERT_EQ(array.n_children, 0);
+    ASSERT_EQ(array.buffers[0], nullptr);
+    ASSERT_EQ(array.buffers[1], data);
+    ASSERT_EQ(static_cast<const int32_t*>(array.buffers[1])[2], 3);
+
+    schema.release(&schema);
+    ASSERT_EQ(schema.release, nullptr);
+    array.release(&array);
+    ASSERT_EQ(array.release, nullptr);
+}
+
+/// Test that releasing the array frees the data block with the vector's allocator, even after the
+/// consumer moved the array struct
+TEST(ArrowTests, ReleaseDeallocates)
+{
+    using Alloc = testing::MockAllocator<double>;
+    auto alloc = Alloc{};
+    EXPECT_CALL(*alloc.mock, allocate(4));
+    auto vec = std::vector<double, Alloc>(alloc);
+    vec.reserve(4);
+    vec.push_back(1.5);
+    const auto* data = vec.data();
+
+    auto leaky_vec = leaky::Vec<double, Alloc>(std::move(vec));
+    ArrowArray array;
+    ArrowSchema schema;
+    leaky::leak_to_arrow(leaky_vec, &array, &schema);
+    ASSERT_STREQ(schema.format, "g");
+    schema.release(&schema);
+
+    // Consumers are allowed to move the struct by copying it and marking the source as released
+    ArrowArray moved;
+    std::memcpy(&moved, &array, sizeof(array));
+    array.release = nullptr;
+
+    testing::Mock::VerifyAndClearExpectations(alloc.mock.get());
+    EXPECT_CALL(*alloc.mock, deallocate(const_cast<double*>(data), 4));
+    moved.release(&moved);
+    ASSERT_EQ(moved.release, nullptr);
+}
+
+/// Test that the vector keeps its allocator, so it can be reused after it's exported
+TEST(ArrowTests, ReuseAfterLeak)
+{
+    using Alloc = testing::MockAllocator<int64_t>;
+    auto alloc = Alloc{};
+    EXPECT_CALL(*alloc.mock, allocate(2));
+    auto vec = std::vector<int64_t, Alloc>(alloc);
+    vec.reserve(2);
+    vec.push_back(1);
+    const auto* data = vec.data();
+
+    auto leaky_vec = leaky::Vec<int64_t, Alloc>(std::move(vec));
+    ArrowArray array;
+    ArrowSchema schema;
+    leaky::leak_to_arrow(leaky_vec, &array, &schema);
+    schema.release(&schema);
+    ASSERT_EQ(leaky_vec.as_ref().get_allocator().mock, alloc.mock);
+
+    EXPECT_CALL(*alloc.mock, allocate(1));
+    leaky_vec.as_mut().push_back(2);
+    auto* other = leaky_vec.as_mut().data();
+    ASSERT_EQ(*other, 2);
+
+    testing::Mock::VerifyAndClearExpectations(alloc.mock.get());
+    EXPECT_CALL(*alloc.mock, deallocate(const_cast<int64_t*>(data), 2));
+    array.release(&array);
+    EXPECT_CALL(*alloc.mock, deallocate(other, 1));
+    static_cast<void>(std::move(leaky_vec).take());
+}
+
+/// Test that an empty vector is exported as an empty array
+TEST(ArrowTests, Empty)
+{
+    auto leaky_vec = leaky::Vec<uint64_t>(std::vector<uint64_t>{});
+    ArrowArray array;
+    ArrowSchema schema;
+    leaky::leak_to_arrow(leaky_vec, &array, &schema);
+    ASSERT_STREQ(schema.format, "L");
+    ASSERT_EQ(array.length, 0);
+    ASSERT_EQ(array.buffers[1], nullptr);
+    array.release(&array);
+    schema.release(&schema);
+}
+
+TEST(ArrowTests, Formats)
+{
+    static_assert(leaky::is_arrow_primitive_v<int8_t>);
+    static_assert(leaky::is_arrow_primitive_v<uint16_t>);
+    static_assert(leaky::is_arrow_primitive_v<float>);
+    static_assert(!leaky::is_arrow_primitive_v<bool>);
+    static_assert(!leaky::is_arrow_primitive_v<long double>);
+    ASSERT_STREQ(leaky::detail::arrow_format<int8_t>(), "c");
+    ASSERT_STREQ(leaky::detail::arrow_format<uint8_t>(), "C");
+    ASSERT_STREQ(leaky::detail::arrow_format<int16_t>(), "s");
+    ASSERT_STREQ(leaky::detail::arrow_format<uint32_t>(), "I");
+    ASSERT_STREQ(leaky::detail::arrow_format<int64_t>(), "l");
+    ASSERT_STREQ(leaky::detail::arrow_format<float>(), "f");
+}
@@ -0,0 +1,83 @@
+#include "log-allocator.hpp"
+
+#include <leakyvec/batch.hpp>
+
+#include <array>
+
+#include <gmock/gmock.h>
+
+/// Test that we can leak a batch of vectors and reconstruct them again
+TEST(BatchTests, LeakAllAndFromPartsAll)
+{
+    auto vecs = std::vector<std::vector<float>>{{1, 2, 3}, {}, {4, 5}};
+    vecs[1].reserve(8);
+    const auto* first_data = vecs[0].data();
+    const auto* second_data = vecs[1].data();
+
+    auto batch = leaky::leak_all(vecs);
+    ASSERT_EQ(batch.size(), 3);
+    ASSERT_EQ(batch.ptrs[0], first_data);
+    ASSERT_EQ(batch.ptrs[1], second_data);
+    ASSERT_EQ(batch.lens, (std::vector<size_t>{3, 0, 2}));
+    ASSERT_EQ(batch.caps[1], 8);
+    for (const auto& vec : vecs)
+    {
+        ASSERT_TRUE(vec.empty());
+        ASSERT_EQ(vec.capacity(), 0);
+    }
+
+    auto vecs2 = leaky::from_parts_all(batch);
+    ASSERT_TRUE(batch.empty());
+    ASSERT_EQ(vecs2.size(), 3);
+    ASSERT_EQ(vecs2[0].data(), first_data);
+    ASSERT_EQ(vecs2[0], (std::vector<float>{1, 2, 3}));
+    ASSERT_EQ(vecs2[1].capacity(), 8);
+    ASSERT_EQ(vecs2[2], (std::vector<float>{4, 5}));
+}
+
+/// Test that the batch can go through the C ABI, with any range of vectors
+TEST(BatchTests, CAbi)
+{
+    using Alloc = testing::LogAllocator<int>;
+    auto vecs = std::array<std::vector<int, Alloc>, 2>{std::vector<int, Alloc>{1},
+                                                       std::vector<int, Alloc>{2, 3}};
+
+    auto batch = leaky::BatchParts<int, Alloc>{};
+    leaky::leak_all(vecs, batch);
+
+    const leaky_raw_parts_batch c_batch = batch.as_c();
+    ASSERT_EQ(c_batch.count, 2);
+    ASSERT_EQ(c_batch.elem_size, sizeof(int));
+    ASSERT_EQ(c_batch.align, alignof(int));
+    ASSERT_EQ(c_batch.ptrs, batch.ptrs.data());
+    ASSERT_EQ(c_batch.lens[1], 2);
+
+    auto vecs2 = std::vector<std::vector<int, Alloc>>{};
+    leaky::from_parts_all(c_batch, vecs2);
+    ASSERT_EQ(vecs2.size(), 2);
+    ASSERT_EQ(vecs2[0][0], 1);
+    ASSERT_EQ(vecs2[1][1], 3);
+}
+
+/// Test that a cleared batch can be reused without reallocating its arrays
+TEST(BatchTests, ReuseBatch)
+{
+    auto batch = leaky::BatchParts<int>{};
+    for (int round = 0; round < 3; round++)
+    {
+        auto vecs = std::vector<std::vector<int>>(16, std::vector<int>{round});
+        leaky::leak_all(vecs, batch);
+        const auto* ptrs = batch.ptrs.data();
+        ASSERT_EQ(batch.size(), 16);
+
+        auto vecs2 = std::vector<std::vector<int>>{};
+        leaky::from_parts_all(batch.as_c(), vecs2);
+        ASSERT_EQ(vecs2[15][0], round);
+        batch.clear();
+
+        auto more = std::vector<std::vector<int>>(16);
+        leaky::leak_all(more, batch);
+        ASSERT_EQ(batch.ptrs.data(), ptrs);
+        batch.clear();
+    }
+}
@@ -0,0 +1,148 @@
+#include "mock-allocator.hpp"
+
+#include <leakyvec/buffer-pool.hpp>
+
+#include <thread>
+
+#include <gmock/gmock.h>
+
+/// Test that a recycled block is handed back without calling the allocator again
+TEST(BufferPoolTests, RecycleAndAcquire)
+{
+    using Alloc = testing::MockAllocator<int>;
+    auto alloc = Alloc{};
+    auto pool = leaky::BufferPool<int, Alloc>(alloc);
+
+    EXPECT_CALL(*alloc.mock, allocate(16));
+    auto vec = pool.acquire(10);
+    ASSERT_TRUE(vec.empty());
+    ASSERT_EQ(vec.capacity(), 16);
+    vec.assign({1, 2, 3});
+    const auto* data = vec.data();
+    testing::Mock::VerifyAndClearExpectations(alloc.mock.get());
+
+    // The steady state doesn't allocate or deallocate
+    for (int i = 0; i < 4; i++)
+    {
+        pool.recycle(std::move(vec));
+        ASSERT_TRUE(vec.empty());
+        ASSERT_EQ(vec.capacity(), 0);
+
+        vec = pool.acquire(16);
+        ASSERT_EQ(vec.data(), data);
+        ASSERT_TRUE(vec.empty());
+        ASSERT_EQ(vec.capacity(), 16);
+        vec.push_back(i);
+    }
+
+    EXPECT_CALL(*alloc.mock, deallocate(const_cast<int*>(data), 16));
+    pool.recycle(std::move(vec));
+}
+
+/// Test that blocks are bucketed by the power of two below their capacity
+TEST(BufferPoolTests, Buckets)
+{
+    auto pool = leaky::BufferPool<int>();
+    auto vec = std::vector<int>();
+    vec.reserve(12);
+    const auto* data = vec.data();
+    pool.recycle(std::move(vec));
+
+    // 12 elements would fit, but the block isn't guaranteed to hold 2^4 elements
+    auto vec2 = pool.acquire(12);
+    ASSERT_NE(vec2.data(), data);
+    ASSERT_EQ(vec2.capacity(), 16);
+
+    auto vec3 = pool.acquire(8);
+    ASSERT_EQ(vec3.data(), data);
+    ASSERT_EQ(vec3.capacity(), 12);
+    pool.recycle(std::move(vec3));
+
+    // Smaller requests may take a block from the next bucket up, but no further
+    auto vec4 = pool.acquire(3);
+    ASSERT_EQ(vec4.data(), data);
+    pool.recycle(std::move(vec4));
+    auto vec5 = pool.acquire(2);
+    ASSERT_NE(vec5.data(), data);
+    ASSERT_EQ(vec5.capacity(), 2);
+}
+
+/// Test that blocks that can't hold a free list node are deallocated immediately
+TEST(BufferPoolTests, SmallBlocks)
+{
+    using Alloc = testing::MockAllocator<uint8_t>;
+    auto alloc = Alloc{};
+    auto pool = leaky::BufferPool<uint8_t, Alloc>(alloc);
+
+    EXPECT_CALL(*alloc.mock, allocate(4));
+    auto vec = pool.acquire(4);
+    EXPECT_CALL(*alloc.mock, deallocate(vec.data(), 4));
+    pool.recycle(std::move(vec));
+}
+
+/// Test that recycled parts are deallocated when the pool is trimmed or destroyed
+TEST(BufferPoolTests, TrimAndDestroy)
+{
+    using Alloc = testing::MockAllocator<double>;
+    auto alloc = Alloc{};
+    EXPECT_CALL(*alloc.mock, allocate(4)).Times(2);
+    auto vec = std::vector<double, Alloc>(alloc);
+    vec.reserve(4);
+    auto vec2 = std::vector<double, Alloc>(alloc);
+    vec2.reserve(4);
+    auto* data = vec.data();
+    auto* data2 = vec2.data();
+
+    {
+        auto pool = leaky::BufferPool<double, Alloc>(alloc);
+        pool.recycle(leaky::Vec<double, Alloc>(std::move(vec)).leak());
+        EXPECT_CALL(*alloc.mock, deallocate(data, 4));
+        pool.trim();
+        testing::Mock::VerifyAndClearExpectations(alloc.mock.get());
+
+        pool.recycle(std::move(vec2));
+        EXPECT_CALL(*alloc.mock, deallocate(data2, 4));
+    }
+}
+
+/// Test that other threads can recycle blocks while the owner acquires them
+TEST(BufferPoolTests, CrossThreadRecycle)
+{
+    constexpr int thread_count = 4;
+    constexpr int blocks_per_thread = 1000;
+    auto pool = leaky::BufferPool<uint64_t>();
+
+    auto vecs = std::vector<std::vector<std::vector<uint64_t>>>(thread_count);
+    for (auto& thread_vecs : vecs)
+    {
+        for (int i = 0; i < blocks_per_thread; i++)
+        {
+            thread_vecs.push_back(pool.acquire(64));
+            thread_vecs.back().push_back(static_cast<uint64_t>(i));
+        }
+    }
+
+    auto threads = std::vector<std::thread>();
+    for (auto& thread_vecs : vecs)
+    {
+        threads.emplace_back([&pool, &thread_vecs] {
+            for (auto& vec : thread_vecs)
+            {
+                pool.recycle(std::move(vec));
+            }
+        });
+    }
+
+    auto reused = std::vector<std::vector<uint64_t>>();
+    while (reused.size() < thread_count * blocks_per_thread / 2)
+    {
+        auto vec = pool.acquire(64);
+        ASSERT_TRUE(vec.empty());
+        ASSERT_EQ(vec.capacity(), 64);
+        reused.push_back(std::move(vec));
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
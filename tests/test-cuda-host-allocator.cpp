@@ -0,0 +1,91 @@
+#include <leakyvec/cuda-host-allocator.hpp>
+#include <leakyvec/leakyvec.hpp>
+
+#include <cstdint>
+#include <numeric>
+
+#include <gmock/gmock.h>
+
+/// @brief Skip the test unless there's a CUDA device to pin memory for
+#define SKIP_WITHOUT_CUDA_DEVICE()                                                                 \
+    do                                                                                             \
+    {                                                                                              \
+        int device_count = 0;                                                                      \
+        if (cudaGetDeviceCount(&device_count) != cudaSuccess || device_count == 0)                 \
+        {                                                                                          \
+            static_cast<void>(cudaGetLastError());                                                 \
+            GTEST_SKIP() << "No CUDA device";                                                      \
+        }                                                                                          \
+    } while (0)
+
+namespace {
+/// @brief A CUDA stream, destroyed at the end of the scope
+struct Stream
+{
+    cudaStream_t stream = nullptr;
+    Stream() { EXPECT_EQ(cudaStreamCreate(&stream), cudaSuccess); }
+    ~Stream() { static_cast<void>(cudaStreamDestroy(stream)); }
+};
+}  // namespace
+
+using PinnedVec = std::vector<float, leaky::CudaHostAllocator<float>>;
+
+/// Test that a pinned vector round-trips through leak() and from_parts()
+TEST(CudaHostAllocatorTests, LeakAndReconstruct)
+{
+    SKIP_WITHOUT_CUDA_DEVICE();
+    auto vec = PinnedVec(1024);
+    std::iota(vec.begin(), vec.end(), 0.0f);
+    const auto* data = vec.data();
+
+    auto parts = leaky::Vec<float, leaky::CudaHostAllocator<float>>(std::move(vec)).leak();
+    ASSERT_EQ(std::get<0>(parts), data);
+    auto vec2 = leaky::Vec<float, leaky::CudaHostAllocator<float>>::from_parts(parts).take();
+    ASSERT_EQ(vec2.data(), data);
+    ASSERT_EQ(vec2[1023], 1023.0f);
+}
+
+/// Test that leaked parts are the source of an async copy, and are freed once it completes
+TEST(CudaHostAllocatorTests, ReclaimAfterStream)
+{
+    SKIP_WITHOUT_CUDA_DEVICE();
+    Stream stream;
+    void* device = nullptr;
+    ASSERT_EQ(cudaMalloc(&device, 1024 * sizeof(float)), cudaSuccess);
+
+    auto reclaimer = leaky::CudaHostReclaimer<float>(stream.stream);
+    for (int i = 0; i < 4; i++)
+    {
+        auto parts = leaky::Vec<float, leaky::CudaHostAllocator<float>>(PinnedVec(1024)).leak();
+        ASSERT_EQ(cudaMemcpyAsync(device,
+                                  std::get<0>(parts),
+                                  1024 * sizeof(float),
+                                  cudaMemcpyHostToDevice,
+                                  stream.stream),
+                  cudaSuccess);
+        reclaimer.release(std::move(parts));
+    }
+
+    // Polling frees the blocks whose copy completed, and synchronizing frees the rest
+    const auto reclaimed = reclaimer.reclaim();
+    ASSERT_EQ(reclaimer.pending(), 4 - reclaimed);
+    ASSERT_EQ(reclaimer.synchronize(), 4 - reclaimed);
+    ASSERT_EQ(reclaimer.pending(), 0);
+    ASSERT_EQ(cudaFree(device), cudaSuccess);
+}
+
+/// Test that a C consumer can release the parts through a leaky_dealloc_fn
+TEST(CudaHostAllocatorTests, ReleaseCallback)
+{
+    SKIP_WITHOUT_CUDA_DEVICE();
+    Stream stream;
+    auto reclaimer = leaky::CudaHostReclaimer<uint8_t>(stream.stream);
+    const leaky_raw_parts parts =
+        leaky::Vec<uint8_t, leaky::CudaHostAllocator<uint8_t>>(
+            std::vector<uint8_t, leaky::CudaHostAllocator<uint8_t>>(64))
+            .leak_to_c();
+
+    const leaky_dealloc_fn dealloc = &leaky::CudaHostReclaimer<uint8_t>::release_callback;
+    dealloc(&reclaimer, parts.ptr, parts.cap);
+    ASSERT_EQ(reclaimer.synchronize(), 1);
+}
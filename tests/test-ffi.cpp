@@ -0,0 +1,76 @@
+#include "log-allocator.hpp"
+
+#include <leakyvec/ffi.h>
+#include <leakyvec/leakyvec.hpp>
+#include <leakyvec/malloc-allocator.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <gmock/gmock.h>
+
+/// The C struct must have the same layout on both sides of the language boundary
+TEST(FfiTests, RawPartsLayout)
+{
+    ASSERT_TRUE(std::is_standard_layout_v<leaky_raw_parts>);
+    ASSERT_TRUE(std::is_trivially_copyable_v<leaky_raw_parts>);
+    ASSERT_EQ(sizeof(leaky_raw_parts), sizeof(void*) + 4 * sizeof(size_t));
+    ASSERT_EQ(offsetof(leaky_raw_parts, ptr), 0);
+    ASSERT_EQ(offsetof(leaky_raw_parts, len), sizeof(void*));
+    ASSERT_EQ(offsetof(leaky_raw_parts, cap), sizeof(void*) + 1 * sizeof(size_t));
+    ASSERT_EQ(offsetof(leaky_raw_parts, elem_size), sizeof(void*) + 2 * sizeof(size_t));
+    ASSERT_EQ(offsetof(leaky_raw_parts, align), sizeof(void*) + 3 * sizeof(size_t));
+}
+
+/// Test that we can leak a vector through the C ABI and reconstruct it again
+TEST(FfiTests, LeakToCAndBack)
+{
+    auto v = std::vector<uint64_t>{1, 2, 3, 4};
+    v.reserve(10);
+    const auto* original_data = v.data();
+
+    auto leaky_v = leaky::Vec<uint64_t>(std::move(v));
+    const leaky_raw_parts parts = leaky_v.leak_to_c();
+    ASSERT_EQ(parts.ptr, original_data);
+    ASSERT_EQ(parts.len, 4);
+    ASSERT_EQ(parts.cap, 10);
+    ASSERT_EQ(parts.elem_size, sizeof(uint64_t));
+    ASSERT_EQ(parts.align, alignof(uint64_t));
+    ASSERT_TRUE(leaky_v.as_ref().empty());
+
+    auto leaky_v2 = leaky::Vec<uint64_t>::from_c(parts);
+    auto v2 = leaky_v2.take();
+    ASSERT_EQ(v2.data(), original_data);
+    ASSERT_EQ(v2.capacity(), 10);
+    ASSERT_EQ(v2, (std::vector<uint64_t>{1, 2, 3, 4}));
+}
+
+/// Stateless non-default allocators can also go through the C ABI
+TEST(FfiTests, StatelessCustomAllocator)
+{
+    using Alloc = testing::LogAllocator<uint8_t>;
+    auto v = std::vector<uint8_t, Alloc>{{1, 2, 3}, Alloc{}};
+
+    auto leaky_v = leaky::Vec<uint8_t, Alloc>(std::move(v));
+    const auto parts = leaky_v.leak_to_c();
+    ASSERT_EQ(parts.len, 3);
+    ASSERT_EQ(parts.elem_size, 1);
+
+    auto v2 = leaky::Vec<uint8_t, Alloc>::from_c(parts).take();
+    ASSERT_EQ(v2.size(), 3);
+    ASSERT_EQ(v2[2], 3);
+}
+
+/// Blocks aligned more strictly than the elements can come back through the C ABI too
+TEST(FfiTests, FromCOverAligned)
+{
+    using MallocVec = leaky::Vec<uint16_t, leaky::MallocAllocator<uint16_t>>;
+    auto* data = static_cast<uint16_t*>(std::aligned_alloc(64, 64));
+    data[0] = 7;
+    const auto parts = leaky_raw_parts{data, 1, 32, sizeof(uint16_t), 64};
+
+    auto v = MallocVec::from_c(parts).take();
+    ASSERT_EQ(v.data(), data);
+    ASSERT_EQ(v.capacity(), 32);
+    ASSERT_EQ(v[0], 7);
+}
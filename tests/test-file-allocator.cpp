@@ -0,0 +1,142 @@
+#include <leakyvec/file-allocator.hpp>
+#include <leakyvec/leakyvec.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+
+#include <gmock/gmock.h>
+#include <unistd.h>
+
+namespace {
+using LeakyFileVec = leaky::Vec<uint32_t, leaky::FileAllocator<uint32_t>>;
+
+/// A unique temporary file path that's deleted when the test is done
+struct TempPath
+{
+    std::string path;
+
+    TempPath()
+    {
+        std::string pattern = "/tmp/leakyvec-test-XXXXXX";
+        const int fd = mkstemp(pattern.data());
+        close(fd);
+        path = pattern;
+    }
+    TempPath(const TempPath&) = delete;
+    TempPath& operator=(const TempPath&) = delete;
+    ~TempPath() { unlink(path.c_str()); }
+};
+}  // namespace
+
+/// Test that a vector's memory is allocated in a file, and can grow
+TEST(FileAllocatorTests, AllocateInFile)
+{
+    const TempPath tmp;
+    auto v = leaky::make_file_vec<uint32_t>(tmp.path);
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        v.push_back(i);
+    }
+    ASSERT_EQ(v.size(), 10000);
+    ASSERT_EQ(v[9999], 9999);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(v.data()) % leaky::MappedFile::header_size(), 0);
+}
+
+/// Test that a reallocation gets a new block, which doesn't overlap the one being moved out of
+TEST(FileAllocatorTests, InsertAtFrontAfterReallocation)
+{
+    const TempPath tmp;
+    auto v = leaky::make_file_vec<uint32_t>(tmp.path);
+    v.assign({1, 2, 3, 4});
+    v.reserve(4);
+    v.insert(v.begin(), 0);
+    ASSERT_THAT(v, testing::ElementsAre(0, 1, 2, 3, 4));
+
+    // Fill a whole page, so that the reallocation maps more than one
+    const auto page_elements = leaky::MappedFile::header_size() / sizeof(uint32_t);
+    v.resize(page_elements);
+    v.shrink_to_fit();
+    v.insert(v.begin(), 42);
+    ASSERT_EQ(v.size(), page_elements + 1);
+    ASSERT_EQ(v[0], 42);
+    ASSERT_EQ(v[1], 0);
+    ASSERT_EQ(v[5], 4);
+}
+
+/// Test that a copy of a file-backed vector gets its own block in the file
+TEST(FileAllocatorTests, CopyIsIndependent)
+{
+    const TempPath tmp;
+    auto v = leaky::make_file_vec<uint32_t>(tmp.path);
+    v.assign({1, 2, 3, 4});
+    auto copy = v;
+    copy[1] = 99;
+    ASSERT_THAT(v, testing::ElementsAre(1, 2, 3, 4));
+    ASSERT_THAT(copy, testing::ElementsAre(1, 99, 3, 4));
+    ASSERT_EQ(copy.get_allocator(), v.get_allocator());
+}
+
+/// Test that a leaked vector can be reconstructed from its file after it's unmapped
+TEST(FileAllocatorTests, LeakAndReopen)
+{
+    const TempPath tmp;
+    {
+        auto v = leaky::make_file_vec<uint32_t>(tmp.path);
+        v.assign({1, 2, 3, 4});
+        v.reserve(1000);
+
+        auto leaky_v = LeakyFileVec(std::move(v));
+        auto parts = leaky::leak_to_file(leaky_v);
+        ASSERT_EQ(std::get<1>(parts), 4);
+        ASSERT_EQ(std::get<2>(parts), 1000);
+
+        // Unmap the memory, as if the process had exited
+        static_cast<void>(LeakyFileVec::from_parts(parts).take());
+    }
+
+    auto parts = leaky::parts_from_file<uint32_t>(tmp.path);
+    auto v = LeakyFileVec::from_parts(parts).take();
+    ASSERT_EQ(v.size(), 4);
+    ASSERT_EQ(v.capacity(), 1000);
+    ASSERT_EQ(v[0], 1);
+    ASSERT_EQ(v[3], 4);
+
+    // The reconstructed vector can keep growing in the same file
+    v.resize(2000, 5);
+    ASSERT_EQ(v[1999], 5);
+}
+
+/// Test that an empty vector can round trip through a file
+TEST(FileAllocatorTests, Empty)
+{
+    const TempPath tmp;
+    auto leaky_v = LeakyFileVec(leaky::make_file_vec<uint32_t>(tmp.path));
+    auto parts = leaky::leak_to_file(leaky_v);
+    ASSERT_EQ(std::get<0>(parts), nullptr);
+
+    auto v = LeakyFileVec::from_parts(leaky::parts_from_file<uint32_t>(tmp.path)).take();
+    ASSERT_TRUE(v.empty());
+    v.push_back(42);
+    ASSERT_EQ(v[0], 42);
+}
+
+/// Test that we refuse to reconstruct a vector of the wrong type, or from a non-vector file
+TEST(FileAllocatorTests, RejectMismatch)
+{
+    const TempPath tmp;
+    auto leaky_v = LeakyFileVec(leaky::make_file_vec<uint32_t>(tmp.path));
+    leaky_v.as_mut().assign({1, 2, 3});
+    auto parts = leaky::leak_to_file(leaky_v);
+    static_cast<void>(LeakyFileVec::from_parts(parts).take());
+
+    ASSERT_THROW(static_cast<void>(leaky::parts_from_file<uint64_t>(tmp.path)),
+                 std::system_error);
+
+    const TempPath empty;
+    ASSERT_THROW(static_cast<void>(leaky::parts_from_file<uint32_t>(empty.path)),
+                 std::system_error);
+    ASSERT_THROW(static_cast<void>(leaky::parts_from_file<uint32_t>(empty.path + "-missing")),
+                 std::system_error);
+}
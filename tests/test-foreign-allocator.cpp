@@ -0,0 +1,125 @@
+#include <leakyvec/foreign-allocator.hpp>
+#include <leakyvec/leakyvec.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <gmock/gmock.h>
+
+namespace {
+using ForeignVec = leaky::Vec<uint8_t, leaky::ForeignAllocator<uint8_t>>;
+
+/// Stands in for a foreign allocator, that frees its memory with free()
+struct ForeignHeap
+{
+    size_t frees = 0;
+    size_t freed_capacity = 0;
+
+    static void dealloc(void* ctx, void* ptr, size_t cap)
+    {
+        auto* heap = static_cast<ForeignHeap*>(ctx);
+        heap->frees++;
+        heap->freed_capacity = cap;
+        std::free(ptr);
+    }
+};
+
+uint8_t* foreign_alloc(size_t cap, size_t len)
+{
+    auto* data = static_cast<uint8_t*>(std::malloc(cap));
+    for (size_t i = 0; i < len; i++)
+    {
+        data[i] = static_cast<uint8_t>(i);
+    }
+    return data;
+}
+}  // namespace
+
+/// The adopted block is freed with the foreign allocator when the vector is dropped
+TEST(ForeignAllocatorTests, FromForeign)
+{
+    ForeignHeap heap;
+    auto* data = foreign_alloc(100, 10);
+    {
+        auto v = ForeignVec::from_foreign(data, 10, 100, &ForeignHeap::dealloc, &heap).take();
+        ASSERT_EQ(v.data(), data);
+        ASSERT_EQ(v.size(), 10);
+        ASSERT_EQ(v.capacity(), 100);
+        ASSERT_EQ(v[9], 9);
+
+        // Copies allocate their own memory
+        auto copy = v;
+        ASSERT_NE(copy.data(), data);
+        ASSERT_EQ(copy, v);
+    }
+    ASSERT_EQ(heap.frees, 1);
+    ASSERT_EQ(heap.freed_capacity, 100);
+}
+
+/// When the vector grows, the adopted block is freed with the foreign allocator, and the new block
+/// is freed with std::allocator
+TEST(ForeignAllocatorTests, Grow)
+{
+    ForeignHeap heap;
+    auto* data = foreign_alloc(10, 10);
+    auto v = ForeignVec::from_foreign(data, 10, 10, &ForeignHeap::dealloc, &heap).take();
+
+    v.push_back(10);
+    ASSERT_EQ(heap.frees, 1);
+    ASSERT_EQ(heap.freed_capacity, 10);
+    ASSERT_NE(v.data(), data);
+    ASSERT_EQ(v[10], 10);
+
+    v.resize(1000);
+    ASSERT_EQ(heap.frees, 1);
+}
+
+/// A vector can adopt a block described by the C ABI raw parts, and leak it again
+TEST(ForeignAllocatorTests, FromForeignRawParts)
+{
+    ForeignHeap heap;
+    auto* data = foreign_alloc(16, 4);
+    const auto parts = leaky_raw_parts{data, 4, 16, sizeof(uint8_t), alignof(uint8_t)};
+
+    auto leaky_v = ForeignVec::from_foreign(parts, &ForeignHeap::dealloc, &heap);
+    ASSERT_EQ(leaky_v.as_ref().size(), 4);
+
+    // The leaked allocator still knows how to free the block
+    auto [leaked, size, capacity, alloc] = leaky_v.leak();
+    ASSERT_EQ(leaked, data);
+    ASSERT_EQ(alloc.foreign_block(), data);
+    ASSERT_EQ(alloc.context(), &heap);
+    alloc.deallocate(leaked, capacity);
+    ASSERT_EQ(heap.frees, 1);
+}
+
+/// A vector can adopt an over-aligned foreign block, like the 64-byte aligned buffers of Arrow
+TEST(ForeignAllocatorTests, FromForeignOverAligned)
+{
+    using WordVec = leaky::Vec<uint32_t, leaky::ForeignAllocator<uint32_t>>;
+    ForeignHeap heap;
+    auto* data = static_cast<uint32_t*>(std::aligned_alloc(64, 64));
+    data[15] = 15;
+    const auto parts = leaky_raw_parts{data, 16, 16, sizeof(uint32_t), 64};
+    ASSERT_TRUE((leaky::detail::is_adoptable_alignment<uint32_t, leaky::ForeignAllocator<uint32_t>>(
+        parts.align)));
+
+    {
+        auto v = WordVec::from_foreign(parts, &ForeignHeap::dealloc, &heap).take();
+        ASSERT_EQ(v.data(), data);
+        ASSERT_EQ(v[15], 15);
+    }
+    ASSERT_EQ(heap.frees, 1);
+    ASSERT_EQ(heap.freed_capacity, 16);
+}
+
+/// Blocks must be aligned to a power of two, at least as strictly as the elements
+TEST(ForeignAllocatorTests, AdoptableAlignment)
+{
+    using Alloc = leaky::ForeignAllocator<uint32_t>;
+    ASSERT_TRUE((leaky::detail::is_adoptable_alignment<uint32_t, Alloc>(4)));
+    ASSERT_TRUE((leaky::detail::is_adoptable_alignment<uint32_t, Alloc>(128)));
+    ASSERT_FALSE((leaky::detail::is_adoptable_alignment<uint32_t, Alloc>(2)));
+    ASSERT_FALSE((leaky::detail::is_adoptable_alignment<uint32_t, Alloc>(0)));
+    ASSERT_FALSE((leaky::detail::is_adoptable_alignment<uint32_t, Alloc>(48)));
+}
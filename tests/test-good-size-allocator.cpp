@@ -0,0 +1,72 @@
+#include <leakyvec/good-size-allocator.hpp>
+#include <leakyvec/leakyvec.hpp>
+
+#include <cstdint>
+#include <numeric>
+
+#include <gmock/gmock.h>
+
+using GoodSizeVec = std::vector<uint8_t, leaky::GoodSizeAllocator<uint8_t>>;
+using LeakyGoodSizeVec = leaky::Vec<uint8_t, leaky::GoodSizeAllocator<uint8_t>>;
+
+/// Test that leaking records the size class of the block as the capacity
+TEST(GoodSizeAllocatorTests, LeakRecordsUsableCapacity)
+{
+    auto vec = GoodSizeVec(13);
+    std::iota(vec.begin(), vec.end(), 0);
+    const auto usable = leaky::GoodSizeAllocator<uint8_t>().usable_capacity(vec.data(), 13);
+    ASSERT_GE(usable, 13);
+
+    auto [data, size, capacity, alloc] = LeakyGoodSizeVec(std::move(vec)).leak();
+    ASSERT_EQ(size, 13);
+    ASSERT_EQ(capacity, usable);
+
+#ifdef LEAKY_USE_JEMALLOC
+    // The slack is usable, and the block is freed with the recorded capacity
+    data[capacity - 1] = 42;
+#else
+    // Without jemalloc, no slack is reported, since writing past the request isn't allowed
+    ASSERT_EQ(capacity, 13);
+#endif
+    auto vec2 = LeakyGoodSizeVec::from_parts({data, size, capacity, alloc}).take();
+    ASSERT_EQ(vec2.capacity(), usable);
+    ASSERT_EQ(vec2[12], 12);
+}
+
+/// Test that the slack can be claimed before leaking, to fill the whole block
+TEST(GoodSizeAllocatorTests, ClaimUsableCapacity)
+{
+    auto leaky_vec = LeakyGoodSizeVec(GoodSizeVec());
+    leaky_vec.as_mut().reserve(leaky::GoodSizeAllocator<uint8_t>::good_size(100));
+    const auto capacity = leaky_vec.claim_usable_capacity();
+    ASSERT_GE(capacity, 100);
+
+    auto [spare, spare_len] = leaky_vec.spare_capacity();
+    ASSERT_EQ(spare_len, capacity);
+    std::fill(spare, spare + spare_len, uint8_t{7});
+    leaky_vec.unsafe_set_len(capacity);
+    ASSERT_EQ(leaky_vec.as_ref().back(), 7);
+
+    // Nothing to claim for an empty vector, or for allocators that don't report their slack
+    ASSERT_EQ(LeakyGoodSizeVec(GoodSizeVec()).claim_usable_capacity(), 0);
+    auto plain = leaky::Vec<int>(std::vector<int>(3));
+    ASSERT_EQ(plain.claim_usable_capacity(), 3);
+}
+
+/// Test that over-aligned types are allocated aligned
+TEST(GoodSizeAllocatorTests, OverAligned)
+{
+    struct alignas(64) Line
+    {
+        uint8_t bytes[64];
+    };
+    auto vec = std::vector<Line, leaky::GoodSizeAllocator<Line>>(3);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(vec.data()) % 64, 0);
+
+    auto [data, size, capacity, alloc] =
+        leaky::Vec<Line, leaky::GoodSizeAllocator<Line>>(std::move(vec)).leak();
+    ASSERT_GE(capacity, 3);
+    static_cast<void>(
+        leaky::Vec<Line, leaky::GoodSizeAllocator<Line>>::from_parts({data, size, capacity, alloc})
+            .take());
+}
@@ -0,0 +1,221 @@
+#include <leakyvec/io-uring-buffers.hpp>
+#include <leakyvec/leakyvec.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+using LeakyRegisteredVec = leaky::Vec<uint8_t, leaky::RegisteredAllocator<uint8_t>>;
+
+/// A minimal io_uring instance that runs one request at a time, set up with raw system calls
+struct RawRing
+{
+    int fd = -1;
+    io_uring_params params = {};
+    void* sq_ring = MAP_FAILED;
+    void* cq_ring = MAP_FAILED;
+    io_uring_sqe* sqes = nullptr;
+    size_t sq_ring_size = 0;
+    size_t cq_ring_size = 0;
+
+    RawRing()
+    {
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, 4, &params));
+        if (fd < 0)
+        {
+            return;
+        }
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sq_ring = mmap(nullptr,
+                       sq_ring_size,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE,
+                       fd,
+                       IORING_OFF_SQ_RING);
+        cq_ring = mmap(nullptr,
+                       cq_ring_size,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE,
+                       fd,
+                       IORING_OFF_CQ_RING);
+        void* sqes_map = mmap(nullptr,
+                              params.sq_entries * sizeof(io_uring_sqe),
+                              PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE,
+                              fd,
+                              IORING_OFF_SQES);
+        sqes = sqes_map == MAP_FAILED ? nullptr : static_cast<io_uring_sqe*>(sqes_map);
+    }
+    RawRing(const RawRing&) = delete;
+    RawRing& operator=(const RawRing&) = delete;
+    ~RawRing()
+    {
+        if (sqes != nullptr)
+        {
+            munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+        }
+        if (cq_ring != MAP_FAILED)
+        {
+            munmap(cq_ring, cq_ring_size);
+        }
+        if (sq_ring != MAP_FAILED)
+        {
+            munmap(sq_ring, sq_ring_size);
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    [[nodiscard]] bool ok() const { return sq_ring != MAP_FAILED && cq_ring != MAP_FAILED && sqes; }
+
+    template<typename U>
+    U* at(void* ring, uint32_t offset)
+    {
+        return reinterpret_cast<U*>(static_cast<uint8_t*>(ring) + offset);
+    }
+
+    /// Submit the request prepared by `prepare`, and wait for its result
+    template<typename Prepare>
+    int run(Prepare&& prepare)
+    {
+        auto* sq_tail = at<std::atomic<unsigned>>(sq_ring, params.sq_off.tail);
+        const auto sq_mask = *at<unsigned>(sq_ring, params.sq_off.ring_mask);
+        const auto tail = sq_tail->load(std::memory_order_relaxed);
+        const auto index = tail & sq_mask;
+        prepare(sqes[index]);
+        at<unsigned>(sq_ring, params.sq_off.array)[index] = index;
+        sq_tail->store(tail + 1, std::memory_order_release);
+
+        if (syscall(__NR_io_uring_enter, fd, 1, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0)
+        {
+            return -errno;
+        }
+
+        auto* cq_head = at<std::atomic<unsigned>>(cq_ring, params.cq_off.head);
+        const auto cq_mask = *at<unsigned>(cq_ring, params.cq_off.ring_mask);
+        const auto head = cq_head->load(std::memory_order_relaxed);
+        const auto res = at<io_uring_cqe>(cq_ring, params.cq_off.cqes)[head & cq_mask].res;
+        cq_head->store(head + 1, std::memory_order_release);
+        return res;
+    }
+};
+
+/// A temporary file filled with the bytes 0, 1, ..., 255, 0, 1, ...
+struct TempFile
+{
+    FILE* file = std::tmpfile();
+
+    explicit TempFile(size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            std::fputc(static_cast<int>(i % 256), file);
+        }
+        std::fflush(file);
+    }
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+    ~TempFile() { std::fclose(file); }
+
+    [[nodiscard]] int fd() const { return fileno(file); }
+};
+}  // namespace
+
+/// Test that vectors take whole buffers from the pool, and give them back when destroyed
+TEST(IoUringBuffersTests, AcquireAndRelease)
+{
+    auto pool = leaky::RegisteredBufferPool(2, 100);
+    ASSERT_EQ(pool.buffer_size(), static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+    ASSERT_EQ(pool.available(), 2);
+
+    auto first = pool.acquire<uint32_t>();
+    ASSERT_EQ(first.capacity(), pool.buffer_size() / sizeof(uint32_t));
+    ASSERT_EQ(pool.buffer_index(first.data()), 0);
+    ASSERT_THROW(first.reserve(first.capacity() + 1), std::length_error);
+    {
+        auto second = pool.acquire<uint32_t>();
+        ASSERT_EQ(pool.buffer_index(second.data()), 1);
+        ASSERT_EQ(pool.available(), 0);
+        ASSERT_THROW(static_cast<void>(pool.acquire<uint32_t>()), std::bad_alloc);
+    }
+    ASSERT_EQ(pool.available(), 1);
+    ASSERT_EQ(pool.buffer_index(&pool), -1);
+}
+
+/// Test that a pool rejects sizes the kernel can't register, rather than dividing by zero
+TEST(IoUringBuffersTests, RejectsBadSizes)
+{
+    using Pool = leaky::RegisteredBufferPool;
+    ASSERT_THROW(Pool(0, 4096), std::bad_array_new_length);
+    ASSERT_THROW(Pool(Pool::max_buffer_count + 1, 4096), std::bad_array_new_length);
+    ASSERT_THROW(Pool(1, 0), std::bad_array_new_length);
+    ASSERT_THROW(Pool(1, Pool::max_buffer_size + 1), std::bad_array_new_length);
+    ASSERT_THROW(Pool(1, SIZE_MAX), std::bad_array_new_length);
+}
+
+/// Test that leaked parts carry their buffer, and that reclaiming them returns it to the pool
+TEST(IoUringBuffersTests, LeakCarriesBufferIndex)
+{
+    auto pool = leaky::RegisteredBufferPool(4, 4096);
+    auto keep = pool.acquire<uint8_t>();
+    auto vec = pool.acquire<uint8_t>();
+    vec.resize(10);
+
+    auto parts = LeakyRegisteredVec(std::move(vec)).leak();
+    ASSERT_EQ(leaky::fixed_buffer_index(parts), 1);
+    ASSERT_EQ(std::get<1>(parts), 10);
+    ASSERT_EQ(std::get<2>(parts), pool.buffer_size());
+    ASSERT_EQ(pool.available(), 2);
+
+    static_cast<void>(LeakyRegisteredVec::from_parts(std::move(parts)).take());
+    ASSERT_EQ(pool.available(), 3);
+}
+
+/// Test buffers cycling through a fixed read, a leak, and a reclaim, without re-registering
+TEST(IoUringBuffersTests, ReadFixed)
+{
+    RawRing ring;
+    if (!ring.ok())
+    {
+        GTEST_SKIP() << "io_uring isn't available";
+    }
+    auto pool = leaky::RegisteredBufferPool(2, 4096);
+    try
+    {
+        pool.register_buffers(ring.fd);
+    } catch (const std::system_error& e)
+    {
+        GTEST_SKIP() << "Can't register buffers: " << e.what();
+    }
+    ASSERT_EQ(pool.ring_fd(), ring.fd);
+
+    const TempFile file(3 * 4096);
+    for (uint64_t round = 0; round < 3; round++)
+    {
+        auto vec = LeakyRegisteredVec(pool.acquire<uint8_t>());
+        vec.as_mut().push_back(42);
+        const int res =
+            ring.run([&](io_uring_sqe& sqe) { leaky::prep_read_fixed(sqe, file.fd(), vec, 1000); });
+        ASSERT_EQ(res, 4095);
+        vec.unsafe_set_len(vec.as_ref().size() + static_cast<size_t>(res));
+
+        auto parts = vec.leak();
+        ASSERT_GE(leaky::fixed_buffer_index(parts), 0);
+        auto received = LeakyRegisteredVec::from_parts(std::move(parts)).take();
+        ASSERT_EQ(received[0], 42);
+        ASSERT_EQ(received[1], 1000 % 256);
+        ASSERT_EQ(received[4095], (1000 + 4094) % 256);
+    }
+    ASSERT_EQ(pool.available(), 2);
+}
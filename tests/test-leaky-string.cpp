@@ -0,0 +1,121 @@
+#include "mock-allocator.hpp"
+
+#include <leakyvec/leakystring.hpp>
+#include <leakyvec/leakyvec.hpp>
+
+#include <string>
+
+#include <gmock/gmock.h>
+
+namespace {
+using MockString = std::basic_string<char, std::char_traits<char>, testing::MockAllocator<char>>;
+using LeakyMockString = leaky::String<char, std::char_traits<char>, testing::MockAllocator<char>>;
+}  // namespace
+
+/// Verify assumptions about the memory layout of a std::string
+TEST(LeakyStringTests, MemoryLayout)
+{
+    auto short_wrapper = leaky::detail::StringWrapper<char>{std::string("short")};
+    ASSERT_EQ(short_wrapper.get_data_ptr_offset(), 0);
+    ASSERT_TRUE(short_wrapper.is_inline());
+    ASSERT_EQ(*short_wrapper.get_data_start_ptr(), short_wrapper.inner.data());
+    ASSERT_EQ(*short_wrapper.get_size_ptr(), 5);
+
+    auto long_wrapper = leaky::detail::StringWrapper<char>{std::string(100, 'x')};
+    ASSERT_FALSE(long_wrapper.is_inline());
+    ASSERT_EQ(*long_wrapper.get_size_ptr(), 100);
+    ASSERT_EQ(*long_wrapper.get_capacity_ptr(), long_wrapper.inner.capacity());
+}
+
+/// Test that a heap-allocated string is leaked without copying, and can be reconstructed
+TEST(LeakyStringTests, LeakHeapAndReconstruct)
+{
+    auto alloc = testing::MockAllocator<char>{};
+    EXPECT_CALL(*alloc.mock, allocate(101)).Times(1);  // 100 characters and the null terminator
+    EXPECT_CALL(*alloc.mock, deallocate(testing::_, 101)).Times(1);  // drop
+
+    auto str = MockString(100, 'x', alloc);
+    const auto* original_data = str.data();
+    auto leaky_str = LeakyMockString(std::move(str));
+
+    auto parts = leaky_str.leak();
+    auto [data, size, capacity, parts_alloc] = parts;
+    ASSERT_EQ(data, original_data);
+    ASSERT_EQ(size, 100);
+    ASSERT_EQ(capacity, 101);
+    ASSERT_EQ(data[100], '\0');
+    ASSERT_TRUE(leaky_str.as_ref().empty());
+
+    auto str2 = LeakyMockString::from_parts(parts).take();
+    ASSERT_EQ(str2.data(), original_data);
+    ASSERT_EQ(str2.size(), 100);
+    ASSERT_EQ(str2.capacity(), 100);
+    ASSERT_EQ(std::string(str2.data(), str2.size()), std::string(100, 'x'));
+}
+
+/// Test that a short string stored inline is copied onto the heap when leaked
+TEST(LeakyStringTests, LeakInline)
+{
+    auto alloc = testing::MockAllocator<char>{};
+    EXPECT_CALL(*alloc.mock, allocate(6)).Times(1);                 // "short" + null terminator
+    EXPECT_CALL(*alloc.mock, deallocate(testing::_, 6)).Times(1);  // manual free
+
+    auto leaky_str = LeakyMockString(MockString("short", alloc));
+    auto [data, size, capacity, parts_alloc] = leaky_str.leak();
+    ASSERT_EQ(size, 5);
+    ASSERT_EQ(capacity, 6);
+    ASSERT_STREQ(data, "short");
+    ASSERT_TRUE(leaky_str.as_ref().empty());
+
+    parts_alloc.deallocate(data, capacity);
+}
+
+/// An empty string leaks as a nullptr, without allocating anything
+TEST(LeakyStringTests, LeakEmpty)
+{
+    auto leaky_str = leaky::String<char>(std::string{});
+    auto parts = leaky_str.leak();
+    ASSERT_EQ(std::get<0>(parts), nullptr);
+    ASSERT_EQ(std::get<2>(parts), 0);
+
+    auto str = leaky::String<char>::from_parts(parts).take();
+    ASSERT_TRUE(str.empty());
+}
+
+/// Strings and vectors of characters can be leaked into each other, with a copy if there's no room
+/// for the null terminator
+TEST(LeakyStringTests, FromVecParts)
+{
+    auto v = std::vector<char>{'a', 'b', 'c'};
+    v.reserve(100);
+    const auto* original_data = v.data();
+    auto spare_parts = leaky::Vec<char>(std::move(v)).leak();
+    auto from_spare = leaky::String<char>::from_parts(spare_parts).take();
+    ASSERT_EQ(from_spare, "abc");
+    ASSERT_EQ(from_spare.data(), original_data);
+
+    auto full = std::vector<char>{'a', 'b', 'c'};
+    full.shrink_to_fit();
+    ASSERT_EQ(full.capacity(), 3);
+    auto full_parts = leaky::Vec<char>(std::move(full)).leak();
+    auto from_full = leaky::String<char>::from_parts(full_parts).take();
+    ASSERT_EQ(from_full, "abc");
+}
+
+/// Test that a string can go through the C ABI
+TEST(LeakyStringTests, LeakToCAndBack)
+{
+    auto leaky_str = leaky::String<char>(std::string(64, 'y'));
+    const auto parts = leaky_str.leak_to_c();
+    ASSERT_EQ(parts.len, 64);
+    ASSERT_EQ(parts.elem_size, 1);
+
+    auto str = leaky::String<char>::from_c(parts).take();
+    ASSERT_EQ(str, std::string(64, 'y'));
+
+    // Other character types work too
+    auto leaky_wide = leaky::String<char32_t>(std::u32string(64, U'z'));
+    const auto wide_parts = leaky_wide.leak_to_c();
+    ASSERT_EQ(wide_parts.elem_size, 4);
+    ASSERT_EQ(leaky::String<char32_t>::from_c(wide_parts).take(), std::u32string(64, U'z'));
+}
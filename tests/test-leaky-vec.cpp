@@ -2,6 +2,9 @@
 
 #include <leakyvec/leakyvec.hpp>
 
+#include <cstring>
+#include <memory>
+
 #include <gmock/gmock.h>
 
 /// Test that we can leak the memory from a std::vector without freeing it
@@ -74,3 +77,225 @@ TEST(LeakyVecTests, LeakAndReconstruct)
     auto leaky_v2 = leaky::Vec<int, testing::MockAllocator<int>>::from_parts(parts);
     auto v2 = leaky_v2.take();
 }
+
+/// Test that we can grow a vector without initializing the new elements
+TEST(LeakyVecTests, ResizeUninit)
+{
+    auto alloc = testing::MockAllocator<uint8_t>{};
+
+    EXPECT_CALL(*alloc.mock, allocate(4)).Times(1);                 // initial allocation
+    EXPECT_CALL(*alloc.mock, allocate(16)).Times(1);                // allocate 16 on resize
+    EXPECT_CALL(*alloc.mock, deallocate(testing::_, 4)).Times(1);   // deallocate first allocation
+    EXPECT_CALL(*alloc.mock, deallocate(testing::_, 16)).Times(1);  // drop
+
+    auto v = std::vector<uint8_t, testing::MockAllocator<uint8_t>>({1, 2, 3, 4}, alloc);
+    auto leaky_v = leaky::Vec<uint8_t, testing::MockAllocator<uint8_t>>(std::move(v));
+
+    leaky_v.resize_uninit(16);
+    ASSERT_EQ(leaky_v.as_ref().size(), 16);
+    ASSERT_EQ(leaky_v.as_ref().capacity(), 16);
+
+    // The original elements were preserved by the reallocation
+    ASSERT_EQ(leaky_v.as_ref()[0], 1);
+    ASSERT_EQ(leaky_v.as_ref()[3], 4);
+
+    // Shrinking doesn't reallocate
+    leaky_v.resize_uninit(8);
+    ASSERT_EQ(leaky_v.as_ref().size(), 8);
+    ASSERT_EQ(leaky_v.as_ref().capacity(), 16);
+}
+
+/// Test that we can fill the spare capacity directly, and then commit the new length
+TEST(LeakyVecTests, SpareCapacityAndSetLen)
+{
+    auto v = std::vector<uint8_t>{1, 2, 3, 4};
+    v.reserve(10);
+    auto leaky_v = leaky::Vec<uint8_t>(std::move(v));
+
+    auto [spare, spare_len] = leaky_v.spare_capacity();
+    ASSERT_EQ(spare, leaky_v.as_ref().data() + 4);
+    ASSERT_EQ(spare_len, 6);
+
+    // Simulate a recv() or memcpy() into the uninitialized tail
+    const uint8_t payload[] = {5, 6, 7};
+    std::memcpy(spare, payload, sizeof(payload));
+    leaky_v.unsafe_set_len(leaky_v.as_ref().size() + sizeof(payload));
+
+    const auto expected = std::vector<uint8_t>{1, 2, 3, 4, 5, 6, 7};
+    ASSERT_EQ(leaky_v.as_ref(), expected);
+    ASSERT_EQ(leaky_v.as_ref().capacity(), 10);
+
+    auto [full, full_len] = leaky_v.spare_capacity();
+    ASSERT_EQ(full, leaky_v.as_ref().data() + 7);
+    ASSERT_EQ(full_len, 3);
+}
+
+namespace {
+/// A handle-like stateful allocator that counts how many times a live handle is copied
+template<typename T>
+struct CopyCountingAllocator
+{
+    using value_type = T;
+    std::shared_ptr<size_t> copies;
+
+    CopyCountingAllocator() : copies(std::make_shared<size_t>(0)) {}
+    CopyCountingAllocator(const CopyCountingAllocator& other) : copies(other.copies)
+    {
+        // Copying a moved-from handle is free, just like copying a null pointer
+        if (copies)
+        {
+            (*copies)++;
+        }
+    }
+    CopyCountingAllocator(CopyCountingAllocator&&) noexcept = default;
+    CopyCountingAllocator& operator=(const CopyCountingAllocator& other)
+    {
+        copies = other.copies;
+        if (copies)
+        {
+            (*copies)++;
+        }
+        return *this;
+    }
+    CopyCountingAllocator& operator=(CopyCountingAllocator&&) noexcept = default;
+    ~CopyCountingAllocator() = default;
+
+    T* allocate(std::size_t n) { return std::allocator<T>{}.allocate(n); }
+    void deallocate(T* p, std::size_t n) { std::allocator<T>{}.deallocate(p, n); }
+};
+
+template<class T, class U>
+bool operator==(const CopyCountingAllocator<T>&, const CopyCountingAllocator<U>&)
+{
+    return true;
+}
+
+template<class T, class U>
+bool operator!=(const CopyCountingAllocator<T>&, const CopyCountingAllocator<U>&)
+{
+    return false;
+}
+}  // namespace
+
+/// Test that leaking and reconstructing an lvalue copies the allocator
+TEST(LeakyVecTests, LeakAndReconstructCopiesAllocator)
+{
+    using Alloc = CopyCountingAllocator<int>;
+    const auto alloc = Alloc{};
+    const auto copies = alloc.copies;
+    auto v = std::vector<int, Alloc>({1, 2, 3, 4}, alloc);
+    *copies = 0;
+
+    auto leaky_v = leaky::Vec<int, Alloc>(std::move(v));
+    const auto parts = leaky_v.leak();
+    ASSERT_GE(*copies, 1);
+
+    *copies = 0;
+    auto v2 = leaky::Vec<int, Alloc>::from_parts(parts).take();
+    ASSERT_GE(*copies, 1);
+    ASSERT_EQ(v2.size(), 4);
+}
+
+/// Test that a leak and reconstruct round trip can move the allocator instead of copying it
+TEST(LeakyVecTests, LeakAndReconstructMovesAllocator)
+{
+    using Alloc = CopyCountingAllocator<int>;
+    auto copies = std::shared_ptr<size_t>{};
+    auto v = std::vector<int, Alloc>({1, 2, 3, 4}, Alloc{});
+    copies = v.get_allocator().copies;
+    const auto* original_data = v.data();
+    *copies = 0;
+
+    auto parts = leaky::Vec<int, Alloc>(std::move(v)).leak();
+    ASSERT_EQ(*copies, 0);
+    ASSERT_EQ(std::get<3>(parts).copies, copies);
+
+    auto leaky_v2 = leaky::Vec<int, Alloc>::from_parts(std::move(parts));
+    ASSERT_EQ(*copies, 0);
+
+    auto parts2 = std::move(leaky_v2).leak();
+    ASSERT_EQ(*copies, 0);
+
+    auto v2 = leaky::Vec<int, Alloc>::from_parts(std::move(parts2)).take();
+    ASSERT_EQ(*copies, 0);
+    ASSERT_EQ(v2.data(), original_data);
+    ASSERT_EQ(v2, (std::vector<int, Alloc>{{1, 2, 3, 4}, Alloc{}}));
+
+    // The reconstructed vector still has a working allocator
+    *copies = 0;
+    v2.resize(100);
+    ASSERT_EQ(v2.get_allocator().copies, copies);
+}
+
+/// Test that a block of bytes can be reinterpreted as a vector of wider elements, and back
+TEST(LeakyVecTests, CastInto)
+{
+    const float samples[2] = {1.5f, -2.0f};
+    auto bytes = std::vector<uint8_t>(sizeof(samples));
+    std::memcpy(bytes.data(), samples, sizeof(samples));
+    bytes.reserve(16);
+    const auto* data = bytes.data();
+
+    auto leaky_bytes = leaky::Vec<uint8_t>(std::move(bytes));
+    auto floats = leaky_bytes.cast_into<float>();
+    ASSERT_TRUE(floats);
+    ASSERT_TRUE(leaky_bytes.as_ref().empty());
+    ASSERT_EQ(leaky_bytes.as_ref().capacity(), 0);
+
+    auto vec = floats->take();
+    static_assert(std::is_same_v<decltype(vec), std::vector<float>>);
+    ASSERT_EQ(static_cast<const void*>(vec.data()), data);
+    ASSERT_EQ(vec, (std::vector<float>{1.5f, -2.0f}));
+    ASSERT_EQ(vec.capacity(), 4);
+
+    auto shorts = leaky::Vec<float>(std::move(vec)).cast_into<int16_t>();
+    ASSERT_TRUE(shorts);
+    ASSERT_EQ(shorts->as_ref().size(), 4);
+    ASSERT_EQ(shorts->as_ref().capacity(), 8);
+}
+
+/// Test that std::allocator blocks of over-aligned types can be cast between equally aligned types
+TEST(LeakyVecTests, CastIntoOverAligned)
+{
+    struct alignas(64) Line
+    {
+        uint8_t bytes[64];
+    };
+    struct alignas(64) Words
+    {
+        uint64_t words[8];
+    };
+    static_assert(alignof(Line) > __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+    auto leaky_lines = leaky::Vec<Line>(std::vector<Line>(3));
+    const auto* data = leaky_lines.as_ref().data();
+    auto words = leaky_lines.cast_into<Words>();
+    ASSERT_TRUE(words);
+    ASSERT_EQ(static_cast<const void*>(words->as_ref().data()), data);
+    ASSERT_EQ(words->as_ref().size(), 3);
+}
+
+/// Test that a cast fails, leaving the vector alone, unless the block divides evenly into `U`
+TEST(LeakyVecTests, CastIntoUnevenOrMisaligned)
+{
+    auto leaky_vec = leaky::Vec<uint8_t>(std::vector<uint8_t>(6));
+    leaky_vec.as_mut().reserve(8);
+    ASSERT_FALSE(leaky_vec.cast_into<uint32_t>());
+    ASSERT_EQ(leaky_vec.as_ref().size(), 6);
+
+    leaky_vec.as_mut().resize(8);
+    leaky_vec.as_mut().shrink_to_fit();
+    ASSERT_TRUE(leaky_vec.cast_into<uint32_t>());
+
+    // The capacity must divide evenly as well as the size
+    auto leaky_vec2 = leaky::Vec<uint8_t>(std::vector<uint8_t>(4));
+    leaky_vec2.as_mut().reserve(6);
+    ASSERT_FALSE(leaky_vec2.cast_into<uint32_t>());
+
+    // Construct a vector over a misaligned block, that's never deallocated
+    alignas(4) uint8_t buffer[12] = {};
+    auto misaligned = leaky::Vec<uint8_t>::from_parts({buffer + 1, 8, 8, {}});
+    ASSERT_FALSE(misaligned.cast_into<uint32_t>());
+    auto [data, size, capacity, alloc] = misaligned.leak();
+    ASSERT_EQ(data, buffer + 1);
+}
@@ -0,0 +1,191 @@
+#include <leakyvec/buffer-pool.hpp>
+#include <leakyvec/leakystring.hpp>
+#include <leakyvec/leakyvec.hpp>
+
+#include <thread>
+
+#include <gmock/gmock.h>
+
+#ifndef LEAKY_ENABLE_LEDGER
+#error "The ledger tests must be built with LEAKY_ENABLE_LEDGER"
+#endif
+
+namespace {
+/// Element types that no other test leaks, so their counters start at zero
+template<int N>
+struct Tag
+{
+    double value;
+};
+
+const void* last_bad_reclaim = nullptr;
+}  // namespace
+
+/// Test that leaking and reclaiming vectors updates the counters of their element type
+TEST(LedgerTests, CountsPerType)
+{
+    using Elem = Tag<0>;
+    auto vec = std::vector<Elem>(3);
+    vec.reserve(4);
+    auto vec2 = std::vector<Elem>(1);
+
+    auto parts = leaky::Vec<Elem>(std::move(vec)).leak();
+    auto parts2 = leaky::Vec<Elem>(std::move(vec2)).leak();
+    auto counters = leaky::ledger::outstanding<Elem>();
+    ASSERT_EQ(counters.buffers, 2);
+    ASSERT_EQ(counters.bytes, 5 * sizeof(Elem));
+    ASSERT_EQ(leaky::ledger::outstanding<Tag<1>>().buffers, 0);
+
+    static_cast<void>(leaky::Vec<Elem>::from_parts(parts).take());
+    counters = leaky::ledger::outstanding<Elem>();
+    ASSERT_EQ(counters.buffers, 1);
+    ASSERT_EQ(counters.bytes, sizeof(Elem));
+
+    // Through the C ABI too
+    auto leaky_vec = leaky::Vec<Elem>::from_parts(std::move(parts2));
+    const auto c_parts = leaky_vec.leak_to_c();
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, 1);
+    static_cast<void>(leaky::Vec<Elem>::from_c(c_parts).take());
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, 0);
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().bytes, 0);
+
+    // Empty vectors don't leak anything
+    static_cast<void>(leaky::Vec<Elem>(std::vector<Elem>{}).leak());
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, 0);
+}
+
+/// Test that the total gauge sums every element type
+TEST(LedgerTests, TotalOutstanding)
+{
+    const auto before = leaky::ledger::total_outstanding();
+    auto parts = leaky::Vec<Tag<2>>(std::vector<Tag<2>>(2)).leak();
+    auto parts2 = leaky::Vec<uint8_t>(std::vector<uint8_t>(10)).leak();
+
+    const auto during = leaky::ledger::total_outstanding();
+    ASSERT_EQ(during.buffers - before.buffers, 2);
+    ASSERT_EQ(during.bytes - before.bytes, 2 * sizeof(Tag<2>) + 10);
+
+    bool found = false;
+    leaky::ledger::for_each_type([&found](const std::type_info& type, auto counters) {
+        if (type == typeid(Tag<2>))
+        {
+            found = true;
+            ASSERT_EQ(counters.buffers, 1);
+        }
+    });
+    ASSERT_TRUE(found);
+
+    static_cast<void>(leaky::Vec<Tag<2>>::from_parts(std::move(parts)).take());
+    static_cast<void>(leaky::Vec<uint8_t>::from_parts(std::move(parts2)).take());
+    const auto after = leaky::ledger::total_outstanding();
+    ASSERT_EQ(after.buffers, before.buffers);
+    ASSERT_EQ(after.bytes, before.bytes);
+}
+
+/// Test that reclaiming the same parts twice is detected when tracking pointers
+TEST(LedgerTests, DoubleReclaim)
+{
+    using Elem = Tag<3>;
+    leaky::ledger::set_track_pointers(true);
+    leaky::ledger::set_reclaim_handler(
+        [](const std::type_info&, const void* ptr) { last_bad_reclaim = ptr; });
+
+    auto parts = leaky::Vec<Elem>(std::vector<Elem>(2)).leak();
+    auto vec = leaky::Vec<Elem>::from_parts(parts).take();
+    ASSERT_EQ(last_bad_reclaim, nullptr);
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, 0);
+
+    auto reclaimed_twice = leaky::Vec<Elem>::from_parts(parts);
+    ASSERT_EQ(last_bad_reclaim, std::get<0>(parts));
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, 0);
+
+    // Don't actually free it twice, and forget about it again
+    static_cast<void>(std::move(reclaimed_twice).leak());
+    leaky::ledger::on_reclaim<Elem>(std::get<0>(parts), std::get<2>(parts));
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, 0);
+
+    leaky::ledger::set_track_pointers(false);
+    leaky::ledger::set_reclaim_handler(nullptr);
+}
+
+/// Test that the sharded counters add up across threads
+TEST(LedgerTests, Threads)
+{
+    using Elem = Tag<4>;
+    constexpr int thread_count = 4;
+    constexpr int leaks_per_thread = 500;
+
+    auto threads = std::vector<std::thread>();
+    auto parts = std::vector<std::vector<std::tuple<Elem*, size_t, size_t, std::allocator<Elem>>>>(
+        thread_count);
+    for (int t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back([&parts, t] {
+            for (int i = 0; i < leaks_per_thread; i++)
+            {
+                parts[t].push_back(leaky::Vec<Elem>(std::vector<Elem>(1)).leak());
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, thread_count * leaks_per_thread);
+
+    // Reclaim on other threads than the ones that leaked
+    threads.clear();
+    for (int t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back([&parts, t] {
+            for (auto& p : parts[(t + 1) % thread_count])
+            {
+                static_cast<void>(leaky::Vec<Elem>::from_parts(std::move(p)).take());
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, 0);
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().bytes, 0);
+}
+
+/// Test that blocks held or freed by a buffer pool are accounted for
+TEST(LedgerTests, BufferPool)
+{
+    using Elem = Tag<5>;
+    {
+        auto pool = leaky::BufferPool<Elem>();
+        pool.recycle(pool.acquire(8));
+        ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, 1);
+        auto vec = pool.acquire(8);
+        ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, 0);
+        pool.recycle(std::move(vec));
+    }
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().buffers, 0);
+    ASSERT_EQ(leaky::ledger::outstanding<Elem>().bytes, 0);
+}
+
+/// Test that leaking and reclaiming strings is counted like vectors of characters
+TEST(LedgerTests, Strings)
+{
+    using Char = char16_t;
+    auto parts = leaky::String<Char>(std::u16string(40, u'x')).leak();
+    const auto capacity = std::get<2>(parts);
+    ASSERT_EQ(leaky::ledger::outstanding<Char>().buffers, 1);
+    ASSERT_EQ(leaky::ledger::outstanding<Char>().bytes, capacity * sizeof(Char));
+
+    // Short strings are copied onto the heap, and count once they are
+    auto short_parts = leaky::String<Char>(std::u16string(u"hi")).leak_to_c();
+    ASSERT_EQ(leaky::ledger::outstanding<Char>().buffers, 2);
+    static_cast<void>(leaky::String<Char>::from_c(short_parts).take());
+    static_cast<void>(leaky::String<Char>::from_parts(parts).take());
+    ASSERT_EQ(leaky::ledger::outstanding<Char>().buffers, 0);
+    ASSERT_EQ(leaky::ledger::outstanding<Char>().bytes, 0);
+
+    // Empty strings don't leak anything
+    static_cast<void>(leaky::String<Char>(std::u16string()).leak());
+    ASSERT_EQ(leaky::ledger::outstanding<Char>().buffers, 0);
+}
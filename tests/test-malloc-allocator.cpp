@@ -0,0 +1,111 @@
+#include <leakyvec/leakyvec.hpp>
+#include <leakyvec/malloc-allocator.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <gmock/gmock.h>
+
+namespace {
+struct alignas(64) CacheLine
+{
+    uint64_t words[8];
+};
+}  // namespace
+
+/// The stateless allocator isn't stored in the std::vector
+TEST(MallocAllocatorTests, MemoryLayout)
+{
+    using Alloc = leaky::MallocAllocator<int>;
+    auto v = std::vector<int, Alloc>{1, 2, 3, 4};
+    v.reserve(10);
+
+    auto wrapper = leaky::detail::VecWrapper<int, Alloc>{std::move(v)};
+    ASSERT_EQ(wrapper.get_data_ptr_offset(), 0);
+    ASSERT_EQ(*wrapper.get_data_start_ptr(), wrapper.inner.data());
+    ASSERT_EQ(*wrapper.get_data_end_ptr(), wrapper.inner.data() + 4);
+    ASSERT_EQ(*wrapper.get_capacity_end_ptr(), wrapper.inner.data() + 10);
+}
+
+/// Test that a leaked vector can be freed with free()
+TEST(MallocAllocatorTests, LeakAndFree)
+{
+    auto v = std::vector<int, leaky::MallocAllocator<int>>{1, 2, 3, 4};
+    auto leaky_v = leaky::Vec<int, leaky::MallocAllocator<int>>(std::move(v));
+
+    const auto parts = leaky_v.leak_to_c();
+    ASSERT_NE(parts.ptr, nullptr);
+    ASSERT_EQ(parts.len, 4);
+
+    std::free(parts.ptr);
+}
+
+/// Test that memory from malloc() can be adopted by a std::vector
+TEST(MallocAllocatorTests, AdoptMalloc)
+{
+    auto* data = static_cast<int*>(std::malloc(10 * sizeof(int)));
+    for (int i = 0; i < 4; i++)
+    {
+        data[i] = i;
+    }
+
+    const auto parts = leaky_raw_parts{data, 4, 10, sizeof(int), alignof(int)};
+    auto v = leaky::Vec<int, leaky::MallocAllocator<int>>::from_c(parts).take();
+    ASSERT_EQ(v.data(), data);
+    ASSERT_EQ(v.capacity(), 10);
+
+    v.push_back(4);
+    ASSERT_EQ(v, (std::vector<int, leaky::MallocAllocator<int>>{0, 1, 2, 3, 4}));
+}
+
+/// Over-aligned types get correctly aligned memory blocks
+TEST(MallocAllocatorTests, OverAligned)
+{
+    auto v = std::vector<CacheLine, leaky::MallocAllocator<CacheLine>>(3);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(v.data()) % 64, 0);
+
+    v.resize(7);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(v.data()) % 64, 0);
+
+    auto leaky_v = leaky::Vec<CacheLine, leaky::MallocAllocator<CacheLine>>(std::move(v));
+    const auto parts = leaky_v.leak_to_c();
+    ASSERT_EQ(parts.align, 64);
+    std::free(parts.ptr);
+}
+
+/// Test that we can grow a vector's memory block with realloc()
+TEST(MallocAllocatorTests, ReserveInPlace)
+{
+    auto v = std::vector<int, leaky::MallocAllocator<int>>{1, 2, 3, 4};
+    auto leaky_v = leaky::Vec<int, leaky::MallocAllocator<int>>(std::move(v));
+
+    leaky_v.reserve_in_place(1 << 20);
+    ASSERT_EQ(leaky_v.as_ref().capacity(), 1 << 20);
+    ASSERT_EQ(leaky_v.as_ref(), (std::vector<int, leaky::MallocAllocator<int>>{1, 2, 3, 4}));
+
+    // Smaller reservations are a no-op, like std::vector::reserve
+    const auto* data = leaky_v.as_ref().data();
+    leaky_v.reserve_in_place(10);
+    ASSERT_EQ(leaky_v.as_ref().capacity(), 1 << 20);
+    ASSERT_EQ(leaky_v.as_ref().data(), data);
+
+    // The reallocated block is still freed correctly by the std::vector
+    leaky_v.as_mut().resize(2 << 20, 5);
+    ASSERT_EQ(leaky_v.as_ref()[3], 4);
+    ASSERT_EQ(leaky_v.as_ref().back(), 5);
+}
+
+/// Test that we can reserve in place for an empty vector, and for over-aligned types
+TEST(MallocAllocatorTests, ReserveInPlaceEmptyOverAligned)
+{
+    auto leaky_v = leaky::Vec<CacheLine, leaky::MallocAllocator<CacheLine>>(
+        std::vector<CacheLine, leaky::MallocAllocator<CacheLine>>{});
+    leaky_v.reserve_in_place(3);
+    ASSERT_EQ(leaky_v.as_ref().capacity(), 3);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(leaky_v.as_ref().data()) % 64, 0);
+
+    leaky_v.as_mut().push_back(CacheLine{{1, 2, 3, 4, 5, 6, 7, 8}});
+    leaky_v.reserve_in_place(100);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(leaky_v.as_ref().data()) % 64, 0);
+    ASSERT_EQ(leaky_v.as_ref()[0].words[7], 8);
+}
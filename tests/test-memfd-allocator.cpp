@@ -0,0 +1,168 @@
+#include <leakyvec/leakyvec.hpp>
+#include <leakyvec/memfd-allocator.hpp>
+
+#include <cstdint>
+#include <numeric>
+#include <system_error>
+
+#include <gmock/gmock.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+using LeakyMemfdVec = leaky::Vec<uint32_t, leaky::MemfdAllocator<uint32_t>>;
+
+/// A connected pair of Unix domain sockets, closed when the test is done
+struct SocketPair
+{
+    int fds[2] = {-1, -1};
+
+    SocketPair() { EXPECT_EQ(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds), 0); }
+    SocketPair(const SocketPair&) = delete;
+    SocketPair& operator=(const SocketPair&) = delete;
+    ~SocketPair()
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+};
+
+/// Leak a vector of 0, 1, ..., n - 1 and send it through the socket
+void send_iota(int socket, uint32_t n)
+{
+    auto vec = leaky::make_memfd_vec<uint32_t>();
+    vec.resize(n);
+    std::iota(vec.begin(), vec.end(), 0);
+    auto parts = LeakyMemfdVec(std::move(vec)).leak();
+    leaky::send_memfd(socket, leaky::memfd_descriptor(parts));
+
+    // The receiver has its own descriptor, so the sender can free the vector right away
+    static_cast<void>(LeakyMemfdVec::from_parts(std::move(parts)).take());
+}
+}  // namespace
+
+/// Test that a vector's memory is allocated in a memory file, and can grow
+TEST(MemfdAllocatorTests, AllocateInMemfd)
+{
+    auto vec = leaky::make_memfd_vec<uint32_t>();
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        vec.push_back(i);
+    }
+    ASSERT_EQ(vec[9999], 9999);
+
+    auto parts = LeakyMemfdVec(std::move(vec)).leak();
+    const auto desc = leaky::memfd_descriptor(parts);
+    ASSERT_EQ(desc.fd, std::get<3>(parts).memory()->fd());
+    ASSERT_EQ(desc.offset % static_cast<size_t>(sysconf(_SC_PAGESIZE)), 0);
+    ASSERT_EQ(desc.len, 10000);
+    // The capacity extends to the end of the last page
+    ASSERT_EQ(desc.cap * sizeof(uint32_t) % static_cast<size_t>(sysconf(_SC_PAGESIZE)), 0);
+    ASSERT_EQ(desc.elem_size, sizeof(uint32_t));
+    static_cast<void>(LeakyMemfdVec::from_parts(std::move(parts)).take());
+}
+
+/// Test that a reallocation gets a new block, which doesn't overlap the one being moved out of
+TEST(MemfdAllocatorTests, InsertAtFrontAfterReallocation)
+{
+    const auto page_elements = static_cast<size_t>(sysconf(_SC_PAGESIZE)) / sizeof(uint32_t);
+    auto vec = leaky::make_memfd_vec<uint32_t>();
+    vec.resize(page_elements);
+    std::iota(vec.begin(), vec.end(), 1);
+    ASSERT_EQ(vec.capacity(), page_elements);
+
+    vec.insert(vec.begin(), 0);
+    ASSERT_EQ(vec[0], 0);
+    ASSERT_EQ(vec[1], 1);
+    ASSERT_EQ(vec[2], 2);
+    ASSERT_EQ(vec[page_elements], page_elements);
+
+    // A copy gets its own block too
+    auto copy = vec;
+    copy[1] = 99;
+    ASSERT_EQ(vec[1], 1);
+
+    // The new block is described at its own offset, and reaches the receiver intact
+    const SocketPair sockets;
+    auto parts = LeakyMemfdVec(std::move(vec)).leak();
+    const auto desc = leaky::memfd_descriptor(parts);
+    ASSERT_GT(desc.offset, 0);
+    leaky::send_memfd(sockets.fds[0], desc);
+    static_cast<void>(LeakyMemfdVec::from_parts(std::move(parts)).take());
+
+    const auto view = leaky::MemfdView<uint32_t>(leaky::recv_memfd(sockets.fds[1]));
+    ASSERT_EQ(view.size(), page_elements + 1);
+    ASSERT_EQ(view[0], 0);
+    ASSERT_EQ(view[1], 1);
+    ASSERT_EQ(view[page_elements], page_elements);
+}
+
+/// Test that a received vector can be rebuilt into an owning std::vector, and grown
+TEST(MemfdAllocatorTests, SendAndReconstruct)
+{
+    const SocketPair sockets;
+    send_iota(sockets.fds[0], 5000);
+
+    auto vec = LeakyMemfdVec::from_parts(leaky::parts_from_memfd<uint32_t>(
+                                             leaky::recv_memfd(sockets.fds[1])))
+                   .take();
+    ASSERT_EQ(vec.size(), 5000);
+    ASSERT_EQ(vec[4999], 4999);
+    vec.resize(100000, 7);
+    ASSERT_EQ(vec[4999], 4999);
+    ASSERT_EQ(vec.back(), 7);
+}
+
+/// Test that a received vector can be mapped read-only, by another process
+TEST(MemfdAllocatorTests, SendToChildProcess)
+{
+    const SocketPair sockets;
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0)
+    {
+        uint64_t sum = 0;
+        const auto view = leaky::MemfdView<uint32_t>(leaky::recv_memfd(sockets.fds[1]));
+        for (const auto value : view)
+        {
+            sum += value;
+        }
+        _exit(view.size() == 1000 && sum == 999 * 1000 / 2 ? 0 : 1);
+    }
+
+    send_iota(sockets.fds[0], 1000);
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+/// Test that the receiver rejects memory files that don't hold a vector of the right type
+TEST(MemfdAllocatorTests, RejectsMismatchedDescriptor)
+{
+    const SocketPair sockets;
+    send_iota(sockets.fds[0], 10);
+    ASSERT_THROW(static_cast<void>(leaky::MemfdView<uint64_t>(leaky::recv_memfd(sockets.fds[1]))),
+                 std::system_error);
+
+    // A memory file that isn't sealed against shrinking could be truncated under the receiver
+    auto vec = leaky::make_memfd_vec<uint32_t>();
+    vec.resize(10);
+    auto parts = LeakyMemfdVec(std::move(vec)).leak();
+    auto desc = leaky::memfd_descriptor(parts);
+    desc.fd = dup(desc.fd);
+    ASSERT_THROW(static_cast<void>(leaky::parts_from_memfd<uint32_t>(desc)), std::system_error);
+    static_cast<void>(LeakyMemfdVec::from_parts(std::move(parts)).take());
+}
+
+/// Test that an empty vector can be sent too
+TEST(MemfdAllocatorTests, SendEmpty)
+{
+    const SocketPair sockets;
+    auto parts = LeakyMemfdVec(leaky::make_memfd_vec<uint32_t>()).leak();
+    leaky::send_memfd(sockets.fds[0], leaky::memfd_descriptor(parts));
+
+    const auto view = leaky::MemfdView<uint32_t>(leaky::recv_memfd(sockets.fds[1]));
+    ASSERT_TRUE(view.empty());
+}
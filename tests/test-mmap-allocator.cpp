@@ -0,0 +1,104 @@
+#include <leakyvec/leakyvec.hpp>
+#include <leakyvec/mmap-allocator.hpp>
+
+#include <cstdint>
+#include <new>
+
+#include <gmock/gmock.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+using MmapVec = std::vector<uint64_t, leaky::MmapAllocator<uint64_t>>;
+using LeakyMmapVec = leaky::Vec<uint64_t, leaky::MmapAllocator<uint64_t>>;
+
+const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}  // namespace
+
+/// Each allocation gets its own page-aligned mapping, rounded up to whole pages
+TEST(MmapAllocatorTests, PageAligned)
+{
+    const auto alloc = leaky::MmapAllocator<uint64_t>{};
+    ASSERT_EQ(alloc.page_size(), page_size);
+    ASSERT_EQ(alloc.mapping_length(1), page_size);
+    ASSERT_EQ(alloc.mapping_length(page_size / sizeof(uint64_t)), page_size);
+    ASSERT_EQ(alloc.mapping_length(page_size / sizeof(uint64_t) + 1), 2 * page_size);
+
+    auto v = MmapVec({1, 2, 3, 4}, alloc);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(v.data()) % page_size, 0);
+
+    v.resize(page_size);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(v.data()) % page_size, 0);
+    ASSERT_EQ(v[3], 4);
+}
+
+/// A leaked vector carries enough information to munmap it manually
+TEST(MmapAllocatorTests, LeakAndMunmap)
+{
+    auto v = MmapVec(1000, 42, leaky::MmapAllocator<uint64_t>{});
+    auto leaky_v = LeakyMmapVec(std::move(v));
+
+    auto [data, size, capacity, alloc] = leaky_v.leak();
+    ASSERT_EQ(size, 1000);
+    ASSERT_EQ(data[999], 42);
+    ASSERT_EQ(munmap(data, alloc.mapping_length(capacity)), 0);
+}
+
+/// Test that the mapping survives a round trip through the leaked parts
+TEST(MmapAllocatorTests, LeakAndReconstruct)
+{
+    const auto options = leaky::MmapOptions{leaky::HugePages::Transparent, /*populate=*/true};
+    auto v = MmapVec(1 << 20, 7, leaky::MmapAllocator<uint64_t>(options));
+    const auto* original_data = v.data();
+
+    auto parts = LeakyMmapVec(std::move(v)).leak();
+    ASSERT_EQ(std::get<3>(parts).options().huge_pages, leaky::HugePages::Transparent);
+
+    auto v2 = LeakyMmapVec::from_parts(parts).take();
+    ASSERT_EQ(v2.data(), original_data);
+    ASSERT_EQ(v2.size(), 1 << 20);
+    ASSERT_EQ(v2.back(), 7);
+}
+
+/// Explicit huge pages only work if the system has reserved some
+TEST(MmapAllocatorTests, ExplicitHugePages)
+{
+    auto alloc = leaky::MmapAllocator<uint8_t>(leaky::MmapOptions{leaky::HugePages::Explicit});
+    ASSERT_EQ(alloc.page_size(), 2 << 20);
+    ASSERT_EQ(alloc.mapping_length(1), 2 << 20);
+
+    uint8_t* p = nullptr;
+    try
+    {
+        p = alloc.allocate(1);
+    } catch (const std::bad_alloc&)
+    {
+        GTEST_SKIP() << "No 2 MiB huge pages are reserved on this system";
+    }
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(p) % (2 << 20), 0);
+    p[0] = 1;
+    alloc.deallocate(p, 1);
+}
+
+/// Test that we can grow a vector's mapping with mremap()
+TEST(MmapAllocatorTests, ReserveInPlace)
+{
+    auto v = MmapVec({1, 2, 3, 4}, leaky::MmapAllocator<uint64_t>{});
+    const auto* original_data = v.data();
+    auto leaky_v = LeakyMmapVec(std::move(v));
+
+    // Growing within the same page doesn't need to touch the mapping at all
+    leaky_v.reserve_in_place(page_size / sizeof(uint64_t));
+    ASSERT_EQ(leaky_v.as_ref().data(), original_data);
+    ASSERT_EQ(leaky_v.as_ref().capacity(), page_size / sizeof(uint64_t));
+
+    leaky_v.reserve_in_place(1 << 20);
+    ASSERT_EQ(leaky_v.as_ref().capacity(), 1 << 20);
+    ASSERT_EQ(leaky_v.as_ref(), (MmapVec{{1, 2, 3, 4}, leaky::MmapAllocator<uint64_t>{}}));
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(leaky_v.as_ref().data()) % page_size, 0);
+
+    // The remapped block is unmapped with its new length
+    auto [data, size, capacity, alloc] = leaky_v.leak();
+    data[capacity - 1] = 42;
+    ASSERT_EQ(munmap(data, alloc.mapping_length(capacity)), 0);
+}
@@ -0,0 +1,93 @@
+#include <leakyvec/arena-allocator.hpp>
+#include <leakyvec/nested.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <gmock/gmock.h>
+
+/// Test that ragged rows are flattened into offsets and one contiguous values buffer
+TEST(NestedTests, LeakNested)
+{
+    auto rows = std::vector<std::vector<int>>{{1, 2, 3}, {}, {4}, {5, 6}};
+    auto parts = leaky::leak_nested(rows);
+    ASSERT_EQ(parts.rows(), 4);
+
+    auto [offsets, offset_count, offsets_capacity, offsets_alloc] = parts.offsets;
+    auto [values, value_count, values_capacity, values_alloc] = parts.values;
+    static_assert(std::is_same_v<decltype(offsets), int64_t*>);
+    ASSERT_EQ(offset_count, 5);
+    ASSERT_EQ((std::vector<int64_t>(offsets, offsets + offset_count)),
+              (std::vector<int64_t>{0, 3, 3, 4, 6}));
+    ASSERT_EQ(value_count, 6);
+    ASSERT_EQ(values_capacity, 6);
+    ASSERT_EQ((std::vector<int>(values, values + value_count)),
+              (std::vector<int>{1, 2, 3, 4, 5, 6}));
+
+    auto [offsets2, values2] = leaky::NestedBuilder<int>::from_parts(std::move(parts)).take();
+    ASSERT_EQ(offsets2.data(), offsets);
+    ASSERT_EQ(values2.data(), values);
+}
+
+/// Test that the values are moved out of the rows, and that the offset type can be chosen
+TEST(NestedTests, LeakNestedMovesValuesWithInt32Offsets)
+{
+    auto rows = std::vector<std::vector<std::string>>{{"a long string, not stored inline"}, {}};
+    const auto* chars = rows[0][0].data();
+
+    auto parts = leaky::leak_nested<int32_t>(rows);
+    using Builder = leaky::NestedBuilder<std::string, std::allocator<std::string>, int32_t>;
+    auto builder = Builder::from_parts(std::move(parts));
+    ASSERT_EQ(builder.offsets(), (std::vector<int32_t>{0, 1, 1}));
+    ASSERT_EQ(builder.values()[0].data(), chars);
+}
+
+/// Test that the builder streams rows straight into the flat layout, and can resume from parts
+TEST(NestedTests, Builder)
+{
+    auto builder = leaky::NestedBuilder<float>();
+    builder.reserve(3, 8);
+    builder.push_back(1.0f);
+    builder.emplace_back(2.0f);
+    builder.finish_row();
+    builder.finish_row();
+    builder.push_row(std::vector<float>{3.0f, 4.0f, 5.0f});
+    ASSERT_EQ(builder.rows(), 3);
+
+    auto parts = std::move(builder).leak();
+    ASSERT_EQ(std::get<1>(parts.values), 5);
+    ASSERT_EQ(std::get<2>(parts.values), 8);
+
+    auto resumed = leaky::NestedBuilder<float>::from_parts(std::move(parts));
+    const float more[] = {6.0f};
+    resumed.append(std::begin(more), std::end(more));
+    resumed.finish_row();
+    ASSERT_EQ(resumed.rows(), 4);
+    ASSERT_EQ(resumed.offsets(), (std::vector<int64_t>{0, 2, 2, 5, 6}));
+    ASSERT_EQ(resumed.values(), (std::vector<float>{1, 2, 3, 4, 5, 6}));
+}
+
+/// Test that both buffers come from the builder's allocator, rebound for the offsets
+TEST(NestedTests, StatefulAllocator)
+{
+    leaky::Arena arena;
+    auto builder = leaky::NestedBuilder<int, leaky::ArenaAllocator<int>>(
+        leaky::ArenaAllocator<int>(arena));
+    builder.push_row(std::vector<int>{1, 2});
+
+    auto parts = std::move(builder).leak();
+    ASSERT_EQ(&std::get<3>(parts.offsets).arena(), &arena);
+    ASSERT_EQ(&std::get<3>(parts.values).arena(), &arena);
+}
+
+/// Test that a row can't end past what the offset type can count
+TEST(NestedTests, OffsetOverflow)
+{
+    auto builder = leaky::NestedBuilder<char, std::allocator<char>, int8_t>();
+    builder.push_row(std::string(std::numeric_limits<int8_t>::max(), 'x'));
+    builder.push_back('y');
+    ASSERT_THROW(builder.finish_row(), std::length_error);
+    ASSERT_EQ(builder.rows(), 1);
+}
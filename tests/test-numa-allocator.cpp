@@ -0,0 +1,87 @@
+#include <leakyvec/leakyvec.hpp>
+#include <leakyvec/numa-allocator.hpp>
+
+#include <cstdint>
+#include <numeric>
+#include <system_error>
+
+#include <gmock/gmock.h>
+#include <unistd.h>
+
+using NumaVec = std::vector<uint64_t, leaky::NumaAllocator<uint64_t>>;
+using LeakyNumaVec = leaky::Vec<uint64_t, leaky::NumaAllocator<uint64_t>>;
+
+namespace {
+size_t page_size()
+{
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+}  // namespace
+
+/// Test that a vector placed on a node reports it in its leaked parts, and is allocated there
+TEST(NumaAllocatorTests, LeakCarriesNode)
+{
+    const int node = numa_max_node();
+    auto vec = NumaVec(leaky::NumaAllocator<uint64_t>::on_node(node));
+    vec.resize(1000);
+    std::iota(vec.begin(), vec.end(), 0);
+    if (numa_available() >= 0)
+    {
+        ASSERT_EQ(leaky::numa_node_of(vec.data()), node);
+    }
+
+    auto [data, size, capacity, alloc] = LeakyNumaVec(std::move(vec)).leak();
+    ASSERT_EQ(size, 1000);
+    ASSERT_EQ(alloc.placement(), leaky::NumaPlacement::Node);
+    ASSERT_EQ(alloc.node(), node);
+    // The capacity extends to the end of the last page
+    ASSERT_EQ(capacity * sizeof(uint64_t) % page_size(), 0);
+    ASSERT_GE(capacity, 1000);
+
+    auto vec2 = LeakyNumaVec::from_parts({data, size, capacity, alloc}).take();
+    ASSERT_EQ(vec2[999], 999);
+    ASSERT_EQ(vec2.get_allocator().node(), node);
+}
+
+/// Test that interleaved and local allocators work, and can free each other's memory
+TEST(NumaAllocatorTests, InterleavedAndLocal)
+{
+    const auto count = 3 * page_size() / sizeof(uint64_t);
+    auto vec = NumaVec(count, 7, leaky::NumaAllocator<uint64_t>::interleaved());
+    ASSERT_EQ(vec.get_allocator().placement(), leaky::NumaPlacement::Interleaved);
+    ASSERT_EQ(vec.get_allocator().node(), -1);
+    ASSERT_EQ(vec.back(), 7);
+
+    ASSERT_EQ(leaky::NumaAllocator<uint64_t>(), leaky::NumaAllocator<uint64_t>::interleaved());
+    auto local = NumaVec();
+    local = std::move(vec);
+    ASSERT_EQ(local.back(), 7);
+}
+
+/// Test that a leaked vector's touched pages can be migrated at handoff
+TEST(NumaAllocatorTests, MoveToNode)
+{
+    if (numa_available() < 0)
+    {
+        GTEST_SKIP() << "No NUMA support";
+    }
+    const auto page_elems = page_size() / sizeof(uint64_t);
+    auto vec = NumaVec(leaky::NumaAllocator<uint64_t>::interleaved());
+    vec.reserve(4 * page_elems);
+    vec.resize(2 * page_elems, 1);
+    auto parts = LeakyNumaVec(std::move(vec)).leak();
+
+    // Only the two touched pages are migrated
+    const int node = numa_max_node();
+    ASSERT_EQ(leaky::move_to_node(parts, node), 2);
+    ASSERT_EQ(std::get<3>(parts).node(), node);
+    ASSERT_EQ(leaky::numa_node_of(std::get<0>(parts)), node);
+    ASSERT_THROW(leaky::move_to_node(parts, numa_max_node() + 1), std::system_error);
+
+    auto vec2 = LeakyNumaVec::from_parts(parts).take();
+    ASSERT_EQ(vec2.front(), 1);
+
+    // The untouched pages are allocated on the node too, once they're touched
+    vec2.resize(4 * page_elems, 2);
+    ASSERT_EQ(leaky::numa_node_of(&vec2.back()), node);
+}
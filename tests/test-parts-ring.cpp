@@ -0,0 +1,163 @@
+#include "mock-allocator.hpp"
+
+#include <leakyvec/parts-ring.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <thread>
+
+#include <gmock/gmock.h>
+
+/// Test that parts go through the ring in order, and that it reports when it's full or empty
+TEST(PartsRingTests, PushAndPop)
+{
+    auto ring = leaky::PartsRing<int>(3);
+    ASSERT_EQ(ring.capacity(), 4);
+    ASSERT_FALSE(ring.try_pop());
+
+    auto datas = std::vector<const int*>();
+    for (int i = 0; i < 4; i++)
+    {
+        auto vec = std::vector<int>{i};
+        datas.push_back(vec.data());
+        ASSERT_TRUE(ring.try_push(leaky::Vec<int>(std::move(vec)).leak()));
+    }
+
+    // A failed push leaves the parts alone
+    auto leaky_vec = leaky::Vec<int>(std::vector<int>{4});
+    auto parts = leaky_vec.leak();
+    ASSERT_FALSE(ring.try_push(std::move(parts)));
+    ASSERT_EQ(std::get<0>(parts)[0], 4);
+    static_cast<void>(leaky::Vec<int>::from_parts(parts).take());
+
+    for (int i = 0; i < 4; i++)
+    {
+        auto popped = ring.try_pop();
+        ASSERT_TRUE(popped);
+        ASSERT_EQ(std::get<0>(*popped), datas[i]);
+        auto vec = leaky::Vec<int>::from_parts(std::move(*popped)).take();
+        ASSERT_EQ(vec, std::vector<int>{i});
+    }
+    ASSERT_FALSE(ring.try_pop());
+}
+
+/// Test that batches stop early when the ring fills up or empties, and wrap around it
+TEST(PartsRingTests, Batches)
+{
+    using Parts = leaky::PartsRing<int>::parts_type;
+    auto ring = leaky::PartsRing<int>(4);
+
+    for (int round = 0; round < 3; round++)
+    {
+        auto parts = std::vector<Parts>();
+        for (int i = 0; i < 6; i++)
+        {
+            parts.push_back(leaky::Vec<int>(std::vector<int>{round, i}).leak());
+        }
+        auto pushed = ring.try_push_n(std::make_move_iterator(parts.begin()), parts.size());
+        ASSERT_EQ(pushed, 4);
+
+        auto popped = std::vector<Parts>();
+        popped.reserve(8);
+        ASSERT_EQ(ring.try_pop_n(std::back_inserter(popped), 3), 3);
+        ASSERT_EQ(ring.try_push_n(std::make_move_iterator(parts.begin() + 4), 2), 2);
+        ASSERT_EQ(ring.try_pop_n(std::back_inserter(popped), 8), 3);
+
+        for (int i = 0; i < 6; i++)
+        {
+            auto vec = leaky::Vec<int>::from_parts(std::move(popped[i])).take();
+            ASSERT_EQ(vec, (std::vector<int>{round, i}));
+        }
+    }
+}
+
+/// Test that the ring frees the parts left in it, with their allocator
+TEST(PartsRingTests, DestroyFreesParts)
+{
+    using Alloc = testing::MockAllocator<int>;
+    auto alloc = Alloc{};
+    EXPECT_CALL(*alloc.mock, allocate(2));
+    auto vec = std::vector<int, Alloc>({1, 2}, alloc);
+    auto* data = vec.data();
+
+    {
+        auto ring = leaky::PartsRing<int, Alloc>(2);
+        ASSERT_TRUE(ring.try_push(leaky::Vec<int, Alloc>(std::move(vec)).leak()));
+        EXPECT_CALL(*alloc.mock, deallocate(data, 2));
+    }
+}
+
+/// Test that every part pushed by many producers is popped exactly once by many consumers
+TEST(PartsRingTests, MultiProducerMultiConsumer)
+{
+    using Parts = leaky::PartsRing<uint64_t>::parts_type;
+    constexpr uint64_t producer_count = 3;
+    constexpr uint64_t consumer_count = 3;
+    constexpr uint64_t parts_per_producer = 2000;
+    constexpr uint64_t total = producer_count * parts_per_producer;
+    auto ring = leaky::PartsRing<uint64_t>(64);
+
+    auto threads = std::vector<std::thread>();
+    for (uint64_t p = 0; p < producer_count; p++)
+    {
+        threads.emplace_back([&ring, p] {
+            for (uint64_t i = 0; i < parts_per_producer; i += 2)
+            {
+                // Alternate between single and batch pushes
+                auto batch = std::vector<Parts>();
+                batch.push_back(leaky::Vec<uint64_t>({p * parts_per_producer + i}).leak());
+                batch.push_back(leaky::Vec<uint64_t>({p * parts_per_producer + i + 1}).leak());
+                while (!ring.try_push(std::move(batch[0])))
+                {
+                    std::this_thread::yield();
+                }
+                while (ring.try_push_n(std::make_move_iterator(batch.begin() + 1), 1) == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    auto seen = std::vector<std::vector<uint64_t>>(consumer_count);
+    auto popped_count = std::atomic<uint64_t>(0);
+    for (uint64_t c = 0; c < consumer_count; c++)
+    {
+        threads.emplace_back([&ring, &seen, &popped_count, c] {
+            auto batch = std::vector<Parts>();
+            batch.reserve(8);
+            while (popped_count.load() < total)
+            {
+                batch.clear();
+                const auto count = ring.try_pop_n(std::back_inserter(batch), 8);
+                if (count == 0)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                popped_count += count;
+                for (auto& parts : batch)
+                {
+                    auto vec = leaky::Vec<uint64_t>::from_parts(std::move(parts)).take();
+                    seen[c].push_back(vec.at(0));
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto all = std::vector<uint64_t>();
+    for (const auto& values : seen)
+    {
+        all.insert(all.end(), values.begin(), values.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto expected = std::vector<uint64_t>(total);
+    std::iota(expected.begin(), expected.end(), 0);
+    ASSERT_EQ(all, expected);
+}
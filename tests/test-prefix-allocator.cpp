@@ -0,0 +1,102 @@
+#include <leakyvec/arena-allocator.hpp>
+#include <leakyvec/leakyvec.hpp>
+#include <leakyvec/malloc-allocator.hpp>
+#include <leakyvec/prefix-allocator.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+#include <gmock/gmock.h>
+
+namespace {
+/// A wire header, as it would precede a payload on a socket
+struct WireHeader
+{
+    uint32_t tag;
+    uint32_t length;
+    uint64_t checksum;
+};
+
+using FrameAlloc =
+    leaky::PrefixAllocator<uint8_t, sizeof(WireHeader), leaky::MallocAllocator<uint8_t>>;
+using LeakyFrameVec = leaky::Vec<uint8_t, FrameAlloc>;
+}  // namespace
+
+/// Test that the header and the payload are leaked as one contiguous frame
+TEST(PrefixAllocatorTests, LeakWithPrefix)
+{
+    auto vec = std::vector<uint8_t, FrameAlloc>(100);
+    std::iota(vec.begin(), vec.end(), 0);
+    const auto* payload = vec.data();
+
+    auto leaky_vec = LeakyFrameVec(std::move(vec));
+    auto leaked = leaky::leak_with_prefix(leaky_vec);
+    ASSERT_EQ(std::get<0>(leaked.parts), payload);
+    ASSERT_EQ(leaked.header() + sizeof(WireHeader), payload);
+    ASSERT_EQ(leaked.frame_size, sizeof(WireHeader) + 100);
+    ASSERT_TRUE(leaky_vec.as_ref().empty());
+
+    const auto header = WireHeader{7, 100, 0xdead'beef};
+    std::memcpy(leaked.header(), &header, sizeof(header));
+    const auto* frame = leaked.frame;
+    ASSERT_EQ(std::memcmp(frame, &header, sizeof(header)), 0);
+    ASSERT_EQ(frame[sizeof(WireHeader) + 99], 99);
+
+    // Reconstructing the vector frees the whole block, prefix included
+    auto vec2 = LeakyFrameVec::from_parts(std::move(leaked.parts)).take();
+    ASSERT_EQ(vec2.data(), payload);
+    ASSERT_EQ(vec2[99], 99);
+}
+
+/// Test that a vector with a prefix can grow, and that the prefix is rounded up to whole elements
+TEST(PrefixAllocatorTests, GrowAndRoundUp)
+{
+    using Alloc = leaky::PrefixAllocator<float, 6>;
+    static_assert(Alloc::prefix_elements == 2);
+
+    auto vec = std::vector<float, Alloc>();
+    for (int i = 0; i < 1000; i++)
+    {
+        vec.push_back(static_cast<float>(i));
+    }
+
+    auto leaky_vec = leaky::Vec<float, Alloc>(std::move(vec));
+    auto leaked = leaky::leak_with_prefix(leaky_vec);
+    auto* data = std::get<0>(leaked.parts);
+    ASSERT_EQ(leaked.header(), reinterpret_cast<uint8_t*>(data) - 6);
+    ASSERT_EQ(leaked.frame_size, 6 + 1000 * sizeof(float));
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(data) % alignof(float), 0);
+
+    auto vec2 = leaky::Vec<float, Alloc>::from_parts(std::move(leaked.parts)).take();
+    ASSERT_EQ(vec2.back(), 999.0f);
+}
+
+/// Test that an empty vector still gets a block to hold its header
+TEST(PrefixAllocatorTests, EmptyPayload)
+{
+    auto leaky_vec = LeakyFrameVec(std::vector<uint8_t, FrameAlloc>());
+    auto leaked = leaky::leak_with_prefix(leaky_vec);
+    ASSERT_NE(leaked.frame, nullptr);
+    ASSERT_EQ(leaked.frame_size, sizeof(WireHeader));
+    ASSERT_EQ(std::get<1>(leaked.parts), 0);
+    static_cast<void>(LeakyFrameVec::from_parts(std::move(leaked.parts)).take());
+}
+
+/// Test that a stateful base allocator is carried through, and rebound
+TEST(PrefixAllocatorTests, StatefulBase)
+{
+    using Alloc = leaky::PrefixAllocator<int, 8, leaky::ArenaAllocator<int>>;
+    leaky::Arena arena;
+    auto vec = std::vector<int, Alloc>({1, 2, 3}, Alloc(leaky::ArenaAllocator<int>(arena)));
+
+    auto leaky_vec = leaky::Vec<int, Alloc>(std::move(vec));
+    auto leaked = leaky::leak_with_prefix(leaky_vec);
+    ASSERT_EQ(&std::get<3>(leaked.parts).base().arena(), &arena);
+    ASSERT_EQ(leaked.frame_size, 8 + 3 * sizeof(int));
+
+    using Rebound = std::allocator_traits<Alloc>::rebind_alloc<uint8_t>;
+    using Expected = leaky::PrefixAllocator<uint8_t, 8, leaky::ArenaAllocator<uint8_t>>;
+    static_assert(std::is_same_v<Rebound, Expected>);
+    ASSERT_EQ(Rebound(std::get<3>(leaked.parts)), std::get<3>(leaked.parts));
+}
@@ -0,0 +1,176 @@
+#include "mock-allocator.hpp"
+
+#include <leakyvec/python.hpp>
+
+#include <memory>
+
+#include <gmock/gmock.h>
+
+class PythonTests : public testing::Test
+{
+  protected:
+    static void SetUpTestSuite() { Py_Initialize(); }
+    static void TearDownTestSuite() { Py_Finalize(); }
+
+    /// Run Python statements with `obj` bound to the name `buf`, and return whether they succeeded
+    static bool run(PyObject* obj, const char* code)
+    {
+        PyObject* globals = PyDict_New();
+        PyDict_SetItemString(globals, "__builtins__", PyEval_GetBuiltins());
+        PyDict_SetItemString(globals, "buf", obj);
+        PyObject* result = PyRun_String(code, Py_file_input, globals, globals);
+        if (result == nullptr)
+        {
+            PyErr_Print();
+        }
+        Py_XDECREF(result);
+        Py_DECREF(globals);
+        return result != nullptr;
+    }
+};
+
+/// Test that the buffer protocol borrows the vector's elements, and writes through to them
+TEST_F(PythonTests, BufferProtocol)
+{
+    auto leaky_vec = leaky::Vec<int32_t>(std::vector<int32_t>{1, 2, 3});
+    auto* data = leaky_vec.as_mut().data();
+
+    PyObject* obj = leaky::leak_to_python(leaky_vec);
+    ASSERT_NE(obj, nullptr);
+    ASSERT_TRUE(leaky_vec.as_ref().empty());
+    ASSERT_EQ(leaky_vec.as_ref().capacity(), 0);
+
+    ASSERT_TRUE(run(obj, R"(
+m = memoryview(buf)
+assert m.format == 'i', m.format
+assert m.itemsize == 4
+assert m.shape == (3,)
+assert not m.readonly
+assert m.tolist() == [1, 2, 3]
+m[0] = 7
+m.release()
+)"));
+    ASSERT_EQ(data[0], 7);
+    Py_DECREF(obj);
+}
+
+/// Test that the array interface describes the vector's elements
+TEST_F(PythonTests, ArrayInterface)
+{
+    auto leaky_vec = leaky::Vec<double>(std::vector<double>{1.5, 2.5});
+    const auto address = reinterpret_cast<uintptr_t>(leaky_vec.as_ref().data());
+
+    PyObject* obj = leaky::leak_to_python(leaky_vec);
+    ASSERT_NE(obj, nullptr);
+    const auto code = R"(
+import sys
+interface = buf.__array_interface__
+assert interface['shape'] == (2,)
+assert interface['typestr'] == ('<f8' if sys.byteorder == 'little' else '>f8')
+assert interface['data'] == ()" + std::to_string(address) + R"(, False)
+assert interface['version'] == 3
+)";
+    ASSERT_TRUE(run(obj, code.c_str()));
+    Py_DECREF(obj);
+}
+
+/// Test that the vector is freed with its own allocator once the last Python reference is gone
+TEST_F(PythonTests, ReleaseDeallocates)
+{
+    using Alloc = testing::MockAllocator<uint8_t>;
+    auto alloc = Alloc{};
+    EXPECT_CALL(*alloc.mock, allocate(16));
+    auto vec = std::vector<uint8_t, Alloc>(alloc);
+    vec.reserve(16);
+    vec.push_back(42);
+    auto* data = vec.data();
+
+    auto leaky_vec = leaky::Vec<uint8_t, Alloc>(std::move(vec));
+    PyObject* obj = leaky::leak_to_python(leaky_vec);
+    ASSERT_NE(obj, nullptr);
+
+    // The memoryview outlives the object's last reference outside of Python
+    PyObject* view = PyMemoryView_FromObject(obj);
+    ASSERT_NE(view, nullptr);
+    Py_DECREF(obj);
+    ASSERT_TRUE(run(view, "assert buf.tolist() == [42]"));
+
+    testing::Mock::VerifyAndClearExpectations(alloc.mock.get());
+    EXPECT_CALL(*alloc.mock, deallocate(data, 16));
+    Py_DECREF(view);
+}
+
+/// Test that the capsule owns the raw parts
+TEST_F(PythonTests, Capsule)
+{
+    auto leaky_vec = leaky::Vec<int64_t>(std::vector<int64_t>{1, 2});
+    const auto* data = leaky_vec.as_ref().data();
+
+    PyObject* capsule = leaky::leak_to_capsule(leaky_vec);
+    ASSERT_NE(capsule, nullptr);
+    ASSERT_TRUE(PyCapsule_IsValid(capsule, "leakyvec.parts"));
+    using Parts = std::tuple<int64_t*, size_t, size_t, std::allocator<int64_t>>;
+    const auto& parts = *static_cast<Parts*>(PyCapsule_GetPointer(capsule, "leakyvec.parts"));
+    ASSERT_EQ(std::get<0>(parts), data);
+    ASSERT_EQ(std::get<1>(parts), 2);
+    Py_DECREF(capsule);
+}
+
+/// Test that destroying a capsule that was renamed reports the error, rather than crashing
+TEST_F(PythonTests, CapsuleRenamed)
+{
+    auto leaky_vec = leaky::Vec<int64_t>(std::vector<int64_t>{1, 2});
+    PyObject* capsule = leaky::leak_to_capsule(leaky_vec);
+    ASSERT_NE(capsule, nullptr);
+    ASSERT_EQ(PyCapsule_SetName(capsule, "other.parts"), 0);
+
+    using Parts = std::tuple<int64_t*, size_t, size_t, std::allocator<int64_t>>;
+    auto parts =
+        std::unique_ptr<Parts>(static_cast<Parts*>(PyCapsule_GetPointer(capsule, "other.parts")));
+    Py_DECREF(capsule);
+    ASSERT_EQ(PyErr_Occurred(), nullptr);
+
+    // The destructor left the parts alone
+    auto vec = leaky::Vec<int64_t>::from_parts(std::move(*parts)).take();
+    ASSERT_EQ(vec, (std::vector<int64_t>{1, 2}));
+}
+
+/// Test that the vector keeps its allocator, so it can be reused after it's leaked into a capsule
+TEST_F(PythonTests, CapsuleReuseAfterLeak)
+{
+    using Alloc = testing::MockAllocator<int32_t>;
+    auto alloc = Alloc{};
+    EXPECT_CALL(*alloc.mock, allocate(2));
+    auto vec = std::vector<int32_t, Alloc>(alloc);
+    vec.reserve(2);
+    vec.push_back(1);
+    auto* data = vec.data();
+
+    auto leaky_vec = leaky::Vec<int32_t, Alloc>(std::move(vec));
+    PyObject* capsule = leaky::leak_to_capsule(leaky_vec);
+    ASSERT_NE(capsule, nullptr);
+    ASSERT_EQ(leaky_vec.as_ref().get_allocator().mock, alloc.mock);
+
+    EXPECT_CALL(*alloc.mock, allocate(1));
+    leaky_vec.as_mut().push_back(2);
+    auto* other = leaky_vec.as_mut().data();
+    ASSERT_EQ(*other, 2);
+
+    testing::Mock::VerifyAndClearExpectations(alloc.mock.get());
+    EXPECT_CALL(*alloc.mock, deallocate(data, 2));
+    Py_DECREF(capsule);
+    EXPECT_CALL(*alloc.mock, deallocate(other, 1));
+    static_cast<void>(std::move(leaky_vec).take());
+}
+
+TEST_F(PythonTests, Formats)
+{
+    static_assert(leaky::is_python_primitive_v<int16_t>);
+    static_assert(!leaky::is_python_primitive_v<bool>);
+    ASSERT_EQ(leaky::detail::buffer_format<int8_t>(), 'b');
+    ASSERT_EQ(leaky::detail::buffer_format<uint16_t>(), 'H');
+    ASSERT_EQ(leaky::detail::buffer_format<uint64_t>(), 'Q');
+    ASSERT_EQ(leaky::detail::buffer_format<float>(), 'f');
+    ASSERT_EQ(leaky::detail::array_interface_kind<uint32_t>(), 'u');
+    ASSERT_EQ(leaky::detail::array_interface_kind<int32_t>(), 'i');
+}
@@ -0,0 +1,65 @@
+#include <leakyvec/ffi.h>
+#include <leakyvec/foreign-allocator.hpp>
+#include <leakyvec/leakyvec.hpp>
+#include <leakyvec/malloc-allocator.hpp>
+
+#include <cstdint>
+#include <numeric>
+
+#include <gmock/gmock.h>
+
+// Defined in the leakyvec Rust crate's demo feature
+extern "C" uint64_t leaky_demo_sum_u64(leaky_raw_parts parts);
+extern "C" leaky_raw_parts leaky_demo_iota_u64(size_t len, size_t cap);
+extern "C" void leaky_demo_dealloc_u64(void* ctx, void* ptr, size_t cap);
+
+using MallocVec = leaky::Vec<uint64_t, leaky::MallocAllocator<uint64_t>>;
+
+/// Hand a std::vector allocated with malloc over to Rust, which is guaranteed to be compatible with
+/// Rust's System allocator
+TEST(RustHandoffTests, CppToRustMalloc)
+{
+    auto v = std::vector<uint64_t, leaky::MallocAllocator<uint64_t>>(100);
+    std::iota(v.begin(), v.end(), 1);
+    auto leaky_v = MallocVec(std::move(v));
+
+    ASSERT_EQ(leaky_demo_sum_u64(leaky_v.leak_to_c()), 5050);
+}
+
+/// Hand an empty std::vector over to Rust, which has a nullptr data block
+TEST(RustHandoffTests, CppToRustEmpty)
+{
+    auto leaky_v = leaky::Vec<uint64_t>(std::vector<uint64_t>{});
+    ASSERT_EQ(leaky_demo_sum_u64(leaky_v.leak_to_c()), 0);
+}
+
+/// Hand a Rust Vec over to C++, which frees it with free()
+TEST(RustHandoffTests, RustToCpp)
+{
+    const leaky_raw_parts parts = leaky_demo_iota_u64(4, 10);
+    ASSERT_EQ(parts.elem_size, sizeof(uint64_t));
+    ASSERT_EQ(parts.align, alignof(uint64_t));
+
+    auto v = MallocVec::from_c(parts).take();
+    ASSERT_EQ(v.data(), parts.ptr);
+    ASSERT_EQ(v.capacity(), 10);
+    ASSERT_EQ(v, (std::vector<uint64_t, leaky::MallocAllocator<uint64_t>>{0, 1, 2, 3}));
+}
+
+/// Hand a Rust Vec over to C++, which frees it by calling back into Rust
+TEST(RustHandoffTests, RustToCppForeign)
+{
+    using ForeignVec = leaky::Vec<uint64_t, leaky::ForeignAllocator<uint64_t>>;
+    const leaky_raw_parts parts = leaky_demo_iota_u64(4, 10);
+
+    auto v = ForeignVec::from_foreign(parts, &leaky_demo_dealloc_u64, nullptr).take();
+    ASSERT_EQ(v.data(), parts.ptr);
+    ASSERT_EQ(v.size(), 4);
+    ASSERT_EQ(v[3], 3);
+
+    // Growing frees the Rust allocation through the callback
+    v.resize(100, 7);
+    ASSERT_NE(v.data(), parts.ptr);
+    ASSERT_EQ(v[3], 3);
+    ASSERT_EQ(v[99], 7);
+}
@@ -3,6 +3,8 @@
 
 #include <leakyvec/leakyvec.hpp>
 
+#include <cstdint>
+#include <memory>
 #include <tuple>
 
 #include <gmock/gmock.h>
@@ -72,6 +74,29 @@ TEST(VecWrapperTests, DefaultAllocMemoryLayout)
     ASSERT_EQ(*capacity_end_ptr, wrapper.inner.data() + wrapper.inner.capacity());
 }
 
+#ifdef LEAKY_LAYOUT_PROBED
+/// Verify that the layout probed at configure time agrees with the built-in layouts
+TEST(VecWrapperTests, ProbedMemoryLayout)
+{
+    const auto* offsets = leaky::config::vector_pointer_offsets;
+    ASSERT_EQ(LEAKY_PROBED_STDLIB_VERSION, LEAKY_STDLIB_VERSION);
+    ASSERT_EQ(leaky::config::vector_words, 3);
+    ASSERT_EQ(offsets[1], offsets[0] + 1);
+    ASSERT_EQ(offsets[2], offsets[0] + 2);
+#if defined(LEAKY_STDLIB_LIBSTDCXX)
+    ASSERT_EQ(offsets[0], 0);
+    ASSERT_TRUE(leaky::config::vector_allocator_first);
+#elif defined(LEAKY_STDLIB_LIBCXX)
+    ASSERT_EQ(offsets[0], 0);
+    ASSERT_FALSE(leaky::config::vector_allocator_first);
+#endif
+
+    auto wrapper = leaky::detail::VecWrapper<int>{std::vector<int>{1, 2}};
+    ASSERT_EQ(wrapper.get_pointer_offset(0), offsets[0]);
+    ASSERT_EQ(wrapper.get_pointer_offset(2), offsets[2]);
+}
+#endif
+
 /// Verify assumptions about the memory layout of a std::vector with a custom allocator
 TEST(VecWrapperTests, CustomAllocMemoryLayout)
 {
@@ -85,7 +110,67 @@ TEST(VecWrapperTests, CustomAllocMemoryLayout)
     v.reserve(10);
 
     auto wrapper = leaky::detail::VecWrapper<int, testing::MockAllocator<int>>{std::move(v)};
+#if defined(LEAKY_STDLIB_LIBCXX)
+    // libc++ stores the allocator after the pointers
+    ASSERT_EQ(wrapper.get_data_ptr_offset(), 0);
+#elif defined(LEAKY_STDLIB_LIBSTDCXX)
     ASSERT_EQ(wrapper.get_data_ptr_offset(), sizeof(alloc) / sizeof(int*));
+#endif
+
+    auto* data_start_ptr = wrapper.get_data_start_ptr();
+    ASSERT_EQ(*data_start_ptr, wrapper.inner.data());
+
+    auto* data_end_ptr = wrapper.get_data_end_ptr();
+    ASSERT_EQ(*data_end_ptr, wrapper.inner.data() + wrapper.inner.size());
+
+    auto* capacity_end_ptr = wrapper.get_capacity_end_ptr();
+    ASSERT_EQ(*capacity_end_ptr, wrapper.inner.data() + wrapper.inner.capacity());
+}
+
+namespace {
+/// A stateful allocator whose size isn't a multiple of the pointer size
+template<typename T>
+struct PaddedAllocator
+{
+    using value_type = T;
+    uint32_t state[3] = {1, 2, 3};
+
+    PaddedAllocator() = default;
+    template<typename U>
+    PaddedAllocator(const PaddedAllocator<U>& other) :
+        state{other.state[0], other.state[1], other.state[2]}
+    {
+    }
+
+    T* allocate(std::size_t n) { return std::allocator<T>{}.allocate(n); }
+    void deallocate(T* p, std::size_t n) { std::allocator<T>{}.deallocate(p, n); }
+};
+
+template<class T, class U>
+bool operator==(const PaddedAllocator<T>&, const PaddedAllocator<U>&)
+{
+    return true;
+}
+
+template<class T, class U>
+bool operator!=(const PaddedAllocator<T>&, const PaddedAllocator<U>&)
+{
+    return false;
+}
+}  // namespace
+
+/// Verify that the pointers following a stateful allocator are found after its padding
+TEST(VecWrapperTests, PaddedAllocMemoryLayout)
+{
+    static_assert(sizeof(PaddedAllocator<int>) % sizeof(int*) != 0);
+
+    auto v = std::vector<int, PaddedAllocator<int>>{1, 2, 3, 4};
+    v.reserve(10);
+
+    auto wrapper = leaky::detail::VecWrapper<int, PaddedAllocator<int>>{std::move(v)};
+#if defined(LEAKY_STDLIB_LIBSTDCXX)
+    ASSERT_EQ(wrapper.get_data_ptr_offset(), 2);
+#endif
 
     auto* data_start_ptr = wrapper.get_data_start_ptr();
     ASSERT_EQ(*data_start_ptr, wrapper.inner.data());